@@ -10,34 +10,14 @@ Ball::Ball(float x, float y, float radius, float r, float g, float b, bool isWhi
     : x(x), y(y), vx(0), vy(0), radius(radius),
     r(r), g(g), b(b), active(true), isWhite(isWhite) {}
 
-void Ball::update(float dt) {
+void Ball::draw(unsigned int shaderProgram, unsigned int VAO, int numSegments) {
     if (!active) return;
 
-    x += vx * dt;
-    y += vy * dt;
+    drawCircle(shaderProgram, VAO, numSegments, x, y, radius, r, g, b);
 }
 
-void Ball::applyFriction(float friction) {
-    if (!active) return;
-
-    float speed = length(vx, vy);
-    if (speed > 0.0001f) {
-        float newSpeed = speed - friction;
-        if (newSpeed < 0) newSpeed = 0;
-
-        float ratio = newSpeed / speed;
-        vx *= ratio;
-        vy *= ratio;
-    }
-    else {
-        vx = 0;
-        vy = 0;
-    }
-}
-
-void Ball::draw(unsigned int shaderProgram, unsigned int VAO, int numSegments) {
-    if (!active) return;
-
+void Ball::drawCircle(unsigned int shaderProgram, unsigned int VAO, int numSegments,
+    float x, float y, float radius, float r, float g, float b) {
     glUseProgram(shaderProgram);
 
     GLint posLoc = glGetUniformLocation(shaderProgram, "uPos");
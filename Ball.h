@@ -16,13 +16,15 @@ public:
     Ball();
     Ball(float x, float y, float radius, float r, float g, float b, bool isWhite = false);
 
-    void update(float dt);
-    void applyFriction(float friction);
     void draw(unsigned int shaderProgram, unsigned int VAO, int numSegments);
 
     bool isStopped() const;
     void stop();
 
+    // Crta krug zadate pozicije, radijusa i boje (koristi i BallRef)
+    static void drawCircle(unsigned int shaderProgram, unsigned int VAO, int numSegments,
+        float x, float y, float radius, float r, float g, float b);
+
     // Generie vertekse za krunicu
     static void generateCircleVertices(std::vector<float>& vertices, int numSegments);
 };
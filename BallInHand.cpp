@@ -0,0 +1,131 @@
+#include "BallInHand.h"
+#include "Header/Util.h"
+#include <cmath>
+
+BallInHand::BallInHand(JobSystem& jobs)
+    : jobs(&jobs), cueBall(0), originX(0.0f), originY(0.0f), spacing(0.0f),
+    columns(0), rows(0), stride(0), lastStride(0), bestIndex(-1) {
+    scratch.resize(jobs.getWorkerCount());
+}
+
+void BallInHand::start(const BallSystem& balls, const Table& table, int cueBall, float spacing) {
+    initial = balls;
+    this->table = table;
+    this->cueBall = cueBall;
+    this->spacing = spacing;
+
+    // The cue is usually pocketed when ball in hand starts; it has to count as active for the aims
+    initial.x[cueBall] = 0.0f;
+    initial.y[cueBall] = 0.0f;
+    initial.vx[cueBall] = 0.0f;
+    initial.vy[cueBall] = 0.0f;
+    initial.setActive(cueBall, true);
+
+    // Whole levels fit the grid exactly: (points - 1) is a multiple of the coarsest stride.
+    // Points past the playfield edge are simply illegal.
+    float radius = toFloat(initial.radius[cueBall]);
+    float inset = table.cushionThickness + radius;
+    originX = table.left + inset;
+    originY = table.bottom + inset;
+    float width = table.right - table.left - 2.0f * inset;
+    float height = table.top - table.bottom - 2.0f * inset;
+    int cellsX = (int)std::ceil(width / spacing / COARSEST_STRIDE) * COARSEST_STRIDE;
+    int cellsY = (int)std::ceil(height / spacing / COARSEST_STRIDE) * COARSEST_STRIDE;
+    columns = cellsX + 1;
+    rows = cellsY + 1;
+
+    scores.assign((size_t)columns * rows, -1.0f);
+    computed.assign((size_t)columns * rows, 0);
+    stride = COARSEST_STRIDE;
+    lastStride = 0;
+    bestIndex = -1;
+
+    for (WorkerScratch& local : scratch) {
+        local.balls = initial;
+    }
+}
+
+bool BallInHand::isLegal(float x, float y) const {
+    float radius = toFloat(initial.radius[cueBall]);
+    float inset = table.cushionThickness + radius;
+    if (x < table.left + inset || x > table.right - inset) return false;
+    if (y < table.bottom + inset || y > table.top - inset) return false;
+
+    // Clear of the pocket pull, not just the capture radius
+    for (const Pocket& pocket : table.pockets) {
+        if (distance(x, y, pocket.x, pocket.y) < pocket.radius + radius) return false;
+    }
+
+    for (size_t i = 0; i < initial.size(); ++i) {
+        if ((int)i == cueBall || !initial.active[i]) continue;
+        float reach = radius + toFloat(initial.radius[i]);
+        float dx = toFloat(initial.x[i]) - x;
+        float dy = toFloat(initial.y[i]) - y;
+        if (dx * dx + dy * dy < reach * reach) return false;
+    }
+    return true;
+}
+
+float BallInHand::evaluate(BallSystem& balls, std::vector<CandidateShot>& aims, float x, float y) const {
+    if (!isLegal(x, y)) return -1.0f;
+
+    balls.x[cueBall] = x;
+    balls.y[cueBall] = y;
+    ComputerPlayer::findAims(balls, table, cueBall, aims);
+    return aims.empty() ? 0.0f : 1.0f / (1.0f + aims.front().difficulty);
+}
+
+bool BallInHand::refine() {
+    if (stride == 0) return false;
+    const int step = stride;
+
+    size_t grain = (size_t)rows / (4 * jobs->getWorkerCount());
+    jobs->parallelFor((size_t)rows, grain > 0 ? grain : 1, [this, step](int worker, size_t begin, size_t end) {
+        WorkerScratch& local = scratch[worker];
+        for (size_t row = begin; row < end; ++row) {
+            if (row % step != 0) continue;
+            for (int column = 0; column < columns; column += step) {
+                int k = index(column, (int)row);
+                if (computed[k]) continue;
+
+                scores[k] = evaluate(local.balls, local.aims, columnX(column), rowY((int)row));
+                computed[k] = 1;
+            }
+        }
+    });
+
+    // First best in row-major order, so ties resolve the same way at every level
+    bestIndex = -1;
+    for (size_t k = 0; k < scores.size(); ++k) {
+        if (computed[k] && scores[k] >= 0.0f && (bestIndex < 0 || scores[k] > scores[bestIndex])) {
+            bestIndex = (int)k;
+        }
+    }
+
+    lastStride = step;
+    stride = step > 1 ? step / 2 : 0;
+    return true;
+}
+
+void BallInHand::refineAll() {
+    while (refine()) {}
+}
+
+float BallInHand::getScore(int column, int row) const {
+    if (computed[index(column, row)] || lastStride == 0) return scores[index(column, row)];
+
+    // Nearest point of the last finished level
+    int c = (column + lastStride / 2) / lastStride * lastStride;
+    int r = (row + lastStride / 2) / lastStride * lastStride;
+    if (c >= columns) c -= lastStride;
+    if (r >= rows) r -= lastStride;
+    return scores[index(c, r)];
+}
+
+bool BallInHand::getBest(float& x, float& y, float& score) const {
+    if (bestIndex < 0) return false;
+    x = columnX(bestIndex % columns);
+    y = rowY(bestIndex / columns);
+    score = scores[bestIndex];
+    return true;
+}
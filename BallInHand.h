@@ -0,0 +1,80 @@
+#ifndef BALL_IN_HAND_H
+#define BALL_IN_HAND_H
+
+#include "ComputerPlayer.h"
+#include "JobSystem.h"
+#include <vector>
+
+// Kugla u ruci: mapa (heatmap) koliko je dobra svaka pozicija bele na stolu.
+// Vrednost tacke je 1 / (1 + tezina) najlakseg slobodnog udarca iz te tacke
+// (ComputerPlayer::findAims - duh kugle i provera zaklonjenosti, bez simulacije),
+// 0 ako slobodnog udarca nema i -1 ako bela tu ne sme da stoji.
+//
+// Mreza se racuna od grube ka finoj: nivo 0 uzima svaku COARSEST_STRIDE-tu tacku
+// najfinije mreze, a svaki sledeci nivo polovi razmak i racuna samo tacke koje
+// jos nisu izracunate, pa grubi nivoi nisu bacen posao. Redovi idu paralelno
+// preko JobSystem-a. Jedan refine po frejmu daje mapu koja se vidi odmah i finije.
+class BallInHand {
+public:
+    // Razmak tacaka na nivou 0, u tackama najfinije mreze (stepen dvojke)
+    static const int COARSEST_STRIDE = 16;
+
+    explicit BallInHand(JobSystem& jobs);
+
+    // Nova mapa za dati raspored (stanje se kopira); spacing je razmak najfinije mreze
+    void start(const BallSystem& balls, const Table& table, int cueBall, float spacing = 0.02f);
+
+    // Racuna sledeci nivo; vraca false kad je najfiniji vec gotov
+    bool refine();
+
+    // Sve nivoe odjednom
+    void refineAll();
+
+    bool isComplete() const { return stride == 0; }
+
+    // Razmak (u tackama najfinije mreze) poslednjeg izracunatog nivoa
+    int getStride() const { return lastStride; }
+
+    int getColumns() const { return columns; }
+    int getRows() const { return rows; }
+    float columnX(int column) const { return originX + column * spacing; }
+    float rowY(int row) const { return originY + row * spacing; }
+
+    // Vrednost tacke; za tacku koja jos nije izracunata, vrednost najblize grube tacke
+    float getScore(int column, int row) const;
+    bool isComputed(int column, int row) const { return computed[index(column, row)] != 0; }
+
+    // Najbolja izracunata pozicija; false ako nijedna tacka nije legalna
+    bool getBest(float& x, float& y, float& score) const;
+
+    // Da li bela sme da stoji na (x, y): na stolu, van dzepa, ne preklapa druge kugle
+    bool isLegal(float x, float y) const;
+
+private:
+    int index(int column, int row) const { return row * columns + column; }
+    float evaluate(BallSystem& balls, std::vector<CandidateShot>& aims, float x, float y) const;
+
+    struct WorkerScratch {
+        BallSystem balls;
+        std::vector<CandidateShot> aims;
+    };
+
+    JobSystem* jobs;
+    std::vector<WorkerScratch> scratch;
+
+    BallSystem initial;
+    Table table;
+    int cueBall;
+
+    float originX, originY, spacing;
+    int columns, rows;
+    int stride;        // razmak sledeceg nivoa, 0 kad je sve izracunato
+    int lastStride;
+
+    std::vector<float> scores;
+    std::vector<unsigned char> computed;
+
+    int bestIndex;
+};
+
+#endif
@@ -0,0 +1,280 @@
+#include "BallSystem.h"
+#include "Header/Util.h"
+#include <cmath>
+#include <algorithm>
+
+BallRef::BallRef(Real& x, Real& y, Real& vx, Real& vy, Real& radius,
+    float& r, float& g, float& b, bool& active, bool& isWhite)
+    : x(x), y(y), vx(vx), vy(vy), radius(radius),
+    r(r), g(g), b(b), active(active), isWhite(isWhite) {}
+
+bool BallRef::isStopped() const {
+    return length(vx, vy) < 0.0001f;
+}
+
+void BallRef::stop() {
+    vx = 0;
+    vy = 0;
+}
+
+void BallRef::draw(unsigned int shaderProgram, unsigned int VAO, int numSegments) const {
+    if (!active) return;
+
+    Ball::drawCircle(shaderProgram, VAO, numSegments, toFloat(x), toFloat(y), toFloat(radius), r, g, b);
+}
+
+BallSystem::BallSystem() : count(0), awakeListDirty(true), tracking(false), trackingGeneration(0) {}
+
+void BallSystem::resize(size_t n) {
+    x.resize(n);
+    y.resize(n);
+    vx.resize(n);
+    vy.resize(n);
+    radius.resize(n);
+    active.resize(n);
+    r.resize(n);
+    g.resize(n);
+    b.resize(n);
+    isWhite.resize(n);
+    prevX.resize(n);
+    prevY.resize(n);
+    asleep.resize(n);
+    restSteps.resize(n);
+    islandParent.resize(n);
+    islandNext.resize(n);
+    changed.resize(n);
+    count = n;
+    awakeListDirty = true;
+}
+
+void BallSystem::clear() {
+    resize(0);
+}
+
+void BallSystem::add(const Ball& ball) {
+    size_t i = count;
+    resize(count + 1);
+
+    x[i] = ball.x;
+    y[i] = ball.y;
+    vx[i] = ball.vx;
+    vy[i] = ball.vy;
+    radius[i] = ball.radius;
+    active[i] = ball.active;
+    r[i] = ball.r;
+    g[i] = ball.g;
+    b[i] = ball.b;
+    isWhite[i] = ball.isWhite;
+    snapPrevious(i);
+
+    asleep[i] = false;
+    restSteps[i] = 0;
+    islandParent[i] = (int)i;
+    islandNext[i] = (int)i;
+}
+
+BallRef BallSystem::operator[](size_t i) {
+    return BallRef(x[i], y[i], vx[i], vy[i], radius[i], r[i], g[i], b[i], active[i], isWhite[i]);
+}
+
+Ball BallSystem::get(size_t i) const {
+    Ball ball(toFloat(x[i]), toFloat(y[i]), toFloat(radius[i]), r[i], g[i], b[i], isWhite[i]);
+    ball.vx = toFloat(vx[i]);
+    ball.vy = toFloat(vy[i]);
+    ball.active = active[i];
+    return ball;
+}
+
+void BallSystem::storePreviousPositions() {
+    if (count == 0) return;
+    std::memcpy(prevX.data(), x.data(), count * sizeof(Real));
+    std::memcpy(prevY.data(), y.data(), count * sizeof(Real));
+}
+
+void BallSystem::snapPrevious(size_t i) {
+    prevX[i] = x[i];
+    prevY[i] = y[i];
+}
+
+uint64_t BallSystem::stateHash() const {
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](const void* data, size_t bytes) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for (size_t k = 0; k < bytes; ++k) {
+            hash ^= p[k];
+            hash *= 1099511628211ULL;
+        }
+    };
+
+    for (size_t i = 0; i < count; ++i) {
+        unsigned char isActive = active[i] ? 1 : 0;
+        mix(&x[i], sizeof(Real));
+        mix(&y[i], sizeof(Real));
+        mix(&vx[i], sizeof(Real));
+        mix(&vy[i], sizeof(Real));
+        mix(&isActive, 1);
+    }
+    return hash;
+}
+
+void BallSystem::setActive(size_t i, bool value) {
+    markChanged((int)i);
+    active[i] = value;
+    awakeListDirty = true;
+}
+
+const std::vector<int>& BallSystem::awakeBalls() const {
+    if (awakeListDirty) {
+        awakeList.clear();
+        for (size_t i = 0; i < count; ++i) {
+            if (active[i] && !asleep[i]) awakeList.push_back((int)i);
+        }
+        awakeListDirty = false;
+    }
+    return awakeList;
+}
+
+void BallSystem::sleep(size_t i) {
+    markChanged((int)i);
+    vx[i] = 0;
+    vy[i] = 0;
+    asleep[i] = true;
+    awakeListDirty = true;
+}
+
+void BallSystem::wake(size_t i) {
+    // Walk the island ring and turn every member back into a singleton
+    int k = (int)i;
+    do {
+        int next = islandNext[k];
+        markChanged(k);
+        asleep[k] = false;
+        restSteps[k] = 0;
+        islandParent[k] = k;
+        islandNext[k] = k;
+        k = next;
+    } while (k != (int)i);
+
+    awakeListDirty = true;
+}
+
+void BallSystem::wakeAll() {
+    for (size_t i = 0; i < count; ++i) {
+        markChanged((int)i);
+        asleep[i] = false;
+        restSteps[i] = 0;
+        islandParent[i] = (int)i;
+        islandNext[i] = (int)i;
+    }
+    awakeListDirty = true;
+}
+
+int BallSystem::islandRoot(int i) {
+    while (islandParent[i] != i) {
+        markChanged(i);
+        islandParent[i] = islandParent[islandParent[i]];
+        i = islandParent[i];
+    }
+    return i;
+}
+
+void BallSystem::joinIslands(size_t i, size_t j) {
+    int rootI = islandRoot((int)i);
+    int rootJ = islandRoot((int)j);
+    if (rootI == rootJ) return;
+
+    // Swapping the successors of one member from each ring splices the rings together
+    markChanged(rootJ);
+    markChanged((int)i);
+    markChanged((int)j);
+    islandParent[rootJ] = rootI;
+    int nextI = islandNext[i];
+    islandNext[i] = islandNext[j];
+    islandNext[j] = nextI;
+}
+
+void BallSystem::beginTracking() {
+    for (int i : changedList) changed[i] = false;
+    changedList.clear();
+    changedList.reserve(count);
+    tracking = true;
+    ++trackingGeneration;
+
+    // Awake balls move on the next step, so they count as changed from the start
+    for (int i : awakeBalls()) markChanged(i);
+}
+
+static void frictionScalar(Real& vx, Real& vy, Real friction) {
+    Real speed = realSqrt(vx * vx + vy * vy);
+    if (speed > 0.0001f) {
+        Real ratio = std::max(speed - friction, Real(0.0f)) / speed;
+        vx *= ratio;
+        vy *= ratio;
+    }
+    else {
+        vx = 0;
+        vy = 0;
+    }
+}
+
+// When most balls are awake the whole-array passes below are cheaper than
+// chasing the awake list; otherwise only the awake balls are touched.
+static bool useAwakeList(size_t awake, size_t count) {
+    return awake * 2 < count;
+}
+
+// Both passes are written branch-free over plain arrays so the compiler can
+// vectorize them; inactive balls are masked out instead of skipped. The bool
+// flags are read as bytes since compilers won't vectorize bool loads.
+
+void BallSystem::integrate(float dt) {
+    const Real step = dt;
+    const std::vector<int>& awake = awakeBalls();
+    if (useAwakeList(awake.size(), count)) {
+        for (int i : awake) {
+            x[i] += vx[i] * step;
+            y[i] += vy[i] * step;
+        }
+        return;
+    }
+
+    Real* px = x.data();
+    Real* py = y.data();
+    const Real* pvx = vx.data();
+    const Real* pvy = vy.data();
+    const unsigned char* pactive = reinterpret_cast<const unsigned char*>(active.data());
+
+    for (size_t i = 0; i < count; ++i) {
+        Real activeStep = pactive[i] ? step : Real(0.0f);
+        px[i] += pvx[i] * activeStep;
+        py[i] += pvy[i] * activeStep;
+    }
+}
+
+void BallSystem::applyFriction(float friction) {
+    const Real amount = friction;
+    const std::vector<int>& awake = awakeBalls();
+    if (useAwakeList(awake.size(), count)) {
+        for (int i : awake) {
+            frictionScalar(vx[i], vy[i], amount);
+        }
+        return;
+    }
+
+    Real* pvx = vx.data();
+    Real* pvy = vy.data();
+    const unsigned char* pactive = reinterpret_cast<const unsigned char*>(active.data());
+
+    for (size_t i = 0; i < count; ++i) {
+        Real speed = realSqrt(pvx[i] * pvx[i] + pvy[i] * pvy[i]);
+        Real newSpeed = std::max(speed - amount, Real(0.0f));
+
+        // Below the rest threshold the ball is stopped outright
+        Real ratio = newSpeed / std::max(speed, Real(0.0001f));
+        ratio = speed > 0.0001f ? ratio : Real(0.0f);
+        ratio = pactive[i] ? ratio : Real(1.0f);
+
+        pvx[i] *= ratio;
+        pvy[i] *= ratio;
+    }
+}
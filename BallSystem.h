@@ -0,0 +1,200 @@
+#ifndef BALL_SYSTEM_H
+#define BALL_SYSTEM_H
+
+#include "Ball.h"
+#include "Real.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+// Poravnanje i korak dopunjavanja nizova - jedan AVX registar (8 float-ova)
+const size_t BALL_SYSTEM_ALIGNMENT = 32;
+const size_t BALL_SYSTEM_LANES = 8;
+
+// Kontinualni niz poravnat na BALL_SYSTEM_ALIGNMENT. Kapacitet se zaokruzuje
+// na BALL_SYSTEM_LANES elemenata, a visak je uvek popunjen nulama.
+// Samo za trivijalne tipove (float, Fixed, int, bool).
+template <typename T>
+class AlignedArray {
+public:
+    AlignedArray() : ptr(nullptr), count(0), capacity(0) {}
+    AlignedArray(const AlignedArray& other) : ptr(nullptr), count(0), capacity(0) {
+        *this = other;
+    }
+    ~AlignedArray() { release(ptr); }
+
+    AlignedArray& operator=(const AlignedArray& other) {
+        if (this == &other) return *this;
+        resize(other.count);
+        if (other.count > 0) std::memcpy(ptr, other.ptr, other.count * sizeof(T));
+        return *this;
+    }
+
+    void resize(size_t n) {
+        if (n > capacity) {
+            size_t newCapacity = n > capacity * 2 ? n : capacity * 2;
+            newCapacity = (newCapacity + BALL_SYSTEM_LANES - 1) / BALL_SYSTEM_LANES * BALL_SYSTEM_LANES;
+            T* newPtr = allocate(newCapacity);
+            std::memset(newPtr, 0, newCapacity * sizeof(T));
+            if (count > 0) std::memcpy(newPtr, ptr, count * sizeof(T));
+            release(ptr);
+            ptr = newPtr;
+            capacity = newCapacity;
+        }
+        else if (n < count) {
+            std::memset(ptr + n, 0, (count - n) * sizeof(T));
+        }
+        count = n;
+    }
+
+    T* data() { return ptr; }
+    const T* data() const { return ptr; }
+    T& operator[](size_t i) { return ptr[i]; }
+    const T& operator[](size_t i) const { return ptr[i]; }
+    size_t size() const { return count; }
+
+private:
+    static T* allocate(size_t n) {
+        // Originalni pokazivac se cuva odmah ispred poravnatog bloka
+        void* raw = std::malloc(n * sizeof(T) + BALL_SYSTEM_ALIGNMENT + sizeof(void*));
+        if (!raw) throw std::bad_alloc();
+        size_t address = reinterpret_cast<size_t>(raw) + sizeof(void*);
+        size_t aligned = (address + BALL_SYSTEM_ALIGNMENT - 1) & ~(BALL_SYSTEM_ALIGNMENT - 1);
+        reinterpret_cast<void**>(aligned)[-1] = raw;
+        return reinterpret_cast<T*>(aligned);
+    }
+
+    static void release(T* p) {
+        if (p) std::free(reinterpret_cast<void**>(p)[-1]);
+    }
+
+    T* ptr;
+    size_t count;
+    size_t capacity;
+};
+
+// Pogled na jednu kuglu u BallSystem-u sa istim poljima kao Ball,
+// tako da kod za unos i crtanje radi kao ranije
+class BallRef {
+public:
+    Real& x;
+    Real& y;
+    Real& vx;
+    Real& vy;
+    Real& radius;
+    float& r;
+    float& g;
+    float& b;
+    bool& active;
+    bool& isWhite;
+
+    BallRef(Real& x, Real& y, Real& vx, Real& vy, Real& radius,
+        float& r, float& g, float& b, bool& active, bool& isWhite);
+
+    bool isStopped() const;
+    void stop();
+    void draw(unsigned int shaderProgram, unsigned int VAO, int numSegments) const;
+};
+
+// Kugle u obliku strukture nizova (SoA). Vruci podaci (pozicija, brzina,
+// radijus, aktivnost) su u zasebnim poravnatim nizovima koje fizika prolazi
+// u celini; boja i isWhite se koriste samo za crtanje i pravila igre.
+class BallSystem {
+public:
+    AlignedArray<Real> x, y;
+    AlignedArray<Real> vx, vy;
+    AlignedArray<Real> radius;
+    AlignedArray<bool> active;
+
+    AlignedArray<float> r, g, b;
+    AlignedArray<bool> isWhite;
+
+    // Pozicije pre poslednjeg fizickog koraka, za interpolaciju pri crtanju
+    AlignedArray<Real> prevX, prevY;
+
+    // Spavanje: kugla koja miruje ispada iz integracije, grube faze i provera stola.
+    // Kugle koje se dodiruju dok spavaju cine ostrvo (prsten preko islandNext,
+    // koren preko islandParent) i bude se zajedno.
+    AlignedArray<bool> asleep;
+    AlignedArray<int> restSteps;     // uzastopni koraci ispod praga brzine
+    AlignedArray<int> islandParent;
+    AlignedArray<int> islandNext;
+
+    BallSystem();
+
+    size_t size() const { return count; }
+    void clear();
+    void add(const Ball& ball);
+
+    BallRef operator[](size_t i);
+    Ball get(size_t i) const;
+
+    // Pomera sve budne aktivne kugle za v*dt
+    void integrate(float dt);
+
+    // Smanjuje brzinu svih budnih aktivnih kugli za friction
+    void applyFriction(float friction);
+
+    void setActive(size_t i, bool value);
+
+    // Aktivne kugle koje nisu uspavane (lista se obnavlja samo kad se nesto promeni)
+    const std::vector<int>& awakeBalls() const;
+
+    // Zaustavlja i uspavljuje kuglu
+    void sleep(size_t i);
+
+    // Budi kuglu i celo njeno ostrvo. Mora se pozvati kad se kugli spolja zada brzina.
+    void wake(size_t i);
+    void wakeAll();
+
+    // Spaja ostrva dve uspavane kugle koje se dodiruju
+    void joinIslands(size_t i, size_t j);
+
+    // Pamti trenutne pozicije kao prethodno stanje (poziva se pre svakog koraka)
+    void storePreviousPositions();
+
+    // Prethodno stanje = trenutno, da se kugla koja je premestena ne interpolira preko stola
+    void snapPrevious(size_t i);
+
+    // Pozicija za crtanje izmedju prethodnog i trenutnog koraka (alpha 0-1)
+    float renderX(size_t i, float alpha) const { return toFloat(prevX[i]) + (toFloat(x[i]) - toFloat(prevX[i])) * alpha; }
+    float renderY(size_t i, float alpha) const { return toFloat(prevY[i]) + (toFloat(y[i]) - toFloat(prevY[i])) * alpha; }
+
+    // Hes pozicija, brzina i aktivnosti (FNV-1a) - za proveru ponavljanja i lockstep
+    uint64_t stateHash() const;
+
+    // Pracenje promena (za Snapshot): od poziva se pamte kugle cije se stanje moglo
+    // promeniti - budne, probudjene, uspavane, upale i one cija su ostrva menjana.
+    // Kugla koja spava i nije dirana ostaje bit-identicna.
+    void beginTracking();
+    const std::vector<int>& changedBalls() const { return changedList; }
+    unsigned getTrackingGeneration() const { return trackingGeneration; }
+
+private:
+    friend class Snapshot;
+
+    void resize(size_t n);
+    int islandRoot(int i);
+
+    void markChanged(int i) {
+        if (tracking && !changed[i]) {
+            changed[i] = true;
+            changedList.push_back(i);
+        }
+    }
+
+    size_t count;
+
+    mutable std::vector<int> awakeList;
+    mutable bool awakeListDirty;
+
+    AlignedArray<bool> changed;
+    std::vector<int> changedList;
+    bool tracking;
+    unsigned trackingGeneration;
+};
+
+#endif
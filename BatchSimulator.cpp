@@ -0,0 +1,67 @@
+#include "BatchSimulator.h"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+BatchSimulator::BatchSimulator(int workerCount)
+    : ownedJobs(new JobSystem(workerCount)), jobs(ownedJobs.get()),
+    mode(BatchMode::Events), stepDt(1.0f / 240.0f), maxTime(120.0), tablesPerSecond(0.0) {
+    scratch.resize(jobs->getWorkerCount());
+}
+
+BatchSimulator::BatchSimulator(JobSystem& jobs)
+    : jobs(&jobs), mode(BatchMode::Events), stepDt(1.0f / 240.0f), maxTime(120.0), tablesPerSecond(0.0) {
+    scratch.resize(jobs.getWorkerCount());
+}
+
+void BatchSimulator::submitSteps(JobGroup& group, BallSystem& balls, const Table& table, size_t k) {
+    jobs->submit(group, [this, &group, &balls, &table, k](int worker) {
+        WorkerScratch& local = scratch[worker];
+        bool done = Physics::stepTowardsRest(balls, table, stepDt, local.broadphase, local.narrowphase,
+            STEP_CHUNK, maxTime, results[k]);
+
+        // Continuation goes to this worker's queue; an idle worker may steal it
+        if (!done) submitSteps(group, balls, table, k);
+    });
+}
+
+const std::vector<Physics::ShotResult>& BatchSimulator::run(std::vector<BallSystem>& states,
+    const std::vector<Physics::Shot>& shots, const Table& table) {
+    if (shots.size() != states.size()) throw std::invalid_argument("BatchSimulator: shot count differs from table count");
+    results.assign(states.size(), Physics::ShotResult());
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t k = 0; k < states.size(); ++k) {
+        Physics::applyShot(states[k], shots[k]);
+    }
+
+    JobGroup group;
+    if (mode == BatchMode::Lanes) {
+        for (size_t begin = 0; begin < states.size(); begin += LANE_BATCH) {
+            int count = (int)std::min(states.size() - begin, (size_t)LANE_BATCH);
+            jobs->submit(group, [this, &states, &table, begin, count](int worker) {
+                scratch[worker].lanes.run(&states[begin], &results[begin], count, table, stepDt, maxTime);
+            });
+        }
+    }
+    else {
+        for (size_t k = 0; k < states.size(); ++k) {
+            BallSystem& balls = states[k];
+            if (mode == BatchMode::Events) {
+                jobs->submit(group, [this, &balls, &table, k](int worker) {
+                    results[k] = Physics::simulateToRest(balls, table, scratch[worker].events, maxTime);
+                });
+            }
+            else {
+                submitSteps(group, balls, table, k);
+            }
+        }
+    }
+    jobs->wait(group);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    tablesPerSecond = seconds > 0.0 ? states.size() / seconds : 0.0;
+
+    return results;
+}
@@ -0,0 +1,74 @@
+#ifndef BATCH_SIMULATOR_H
+#define BATCH_SIMULATOR_H
+
+#include "Physics.h"
+#include "JobSystem.h"
+#include "LaneStepper.h"
+#include <memory>
+#include <vector>
+
+// Kako BatchSimulator vodi sto do mirovanja
+enum class BatchMode {
+    Events,  // Physics::simulateToRest - najbrze
+    Steps,   // Physics::runToRest sa fiksnim korakom - isti kod kao igra
+    Lanes    // LaneStepper: isto sto i Steps, 8 stolova po jezgru odjednom
+};
+
+// Simulira mnogo nezavisnih stolova (bez prozora) do mirovanja preko JobSystem-a.
+// Svaki sto je jedan posao; u rezimu Steps posao odradi STEP_CHUNK koraka i, ako
+// udarac nije gotov, doda nastavak, pa radnici sa kratkim udarcima kradu ostatak
+// posla od onih sa dugim. U rezimu Lanes posao je grupa od LANE_BATCH stolova.
+// Svaki radnik ima svoj EventSimulator, grubu i usku fazu i LaneStepper
+// koji se ponovo koriste izmedju stolova, a globalnog stanja nema.
+class BatchSimulator {
+public:
+    // Koraka po poslu u rezimu Steps
+    static const int STEP_CHUNK = 256;
+
+    // Stolova po poslu u rezimu Lanes (trake se pune redom iz ove grupe)
+    static const int LANE_BATCH = 64;
+
+    // Sopstveni JobSystem sa workerCount radnika (0 = broj jezgara)
+    explicit BatchSimulator(int workerCount = 0);
+
+    // Deli JobSystem sa ostatkom programa (npr. sa evaluacijom udaraca)
+    explicit BatchSimulator(JobSystem& jobs);
+
+    void setMode(BatchMode mode) { this->mode = mode; }
+    void setStepDt(float dt) { stepDt = dt; }
+    void setMaxTime(double seconds) { maxTime = seconds; }
+
+    // Zadaje shots[k] stolu states[k] i simulira sve do mirovanja. Stanja se menjaju na mestu.
+    // Vraca ishod za svaki sto, istim redom. Baca std::invalid_argument ako se broj
+    // udaraca i stolova razlikuje.
+    const std::vector<Physics::ShotResult>& run(std::vector<BallSystem>& states,
+        const std::vector<Physics::Shot>& shots, const Table& table);
+
+    int getWorkerCount() const { return jobs->getWorkerCount(); }
+    JobSystem& getJobSystem() { return *jobs; }
+
+    // Protok poslednjeg run-a
+    double getTablesPerSecond() const { return tablesPerSecond; }
+
+private:
+    struct WorkerScratch {
+        EventSimulator events;
+        GridBroadphase broadphase;
+        Narrowphase narrowphase;
+        LaneStepper lanes;
+    };
+
+    void submitSteps(JobGroup& group, BallSystem& balls, const Table& table, size_t k);
+
+    std::unique_ptr<JobSystem> ownedJobs;
+    JobSystem* jobs;
+    std::vector<WorkerScratch> scratch;
+    std::vector<Physics::ShotResult> results;
+
+    BatchMode mode;
+    float stepDt;
+    double maxTime;
+    double tablesPerSecond;
+};
+
+#endif
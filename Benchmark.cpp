@@ -0,0 +1,117 @@
+#include "Benchmark.h"
+#include "Physics.h"
+#include "Snapshot.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+namespace Benchmark {
+
+    static const int PHYSICS_SHOTS = 200;
+    static const float PHYSICS_DT = 1.0f / 240.0f;
+    static const int PHYSICS_MAX_STEPS = 240 * 20;
+    static const int SNAPSHOT_ITERATIONS = 1000000;
+
+    // Cue ball and a 15-ball triangle, the same for every build
+    static void setupRack(BallSystem& balls) {
+        const float radius = 0.025f;
+        balls.clear();
+        balls.add(Ball(-0.4f, 0.0f, radius, 1.0f, 1.0f, 1.0f, true));
+        for (int row = 0; row < 5; ++row) {
+            for (int k = 0; k <= row; ++k) {
+                balls.add(Ball(0.3f + row * 0.0445f, (k - row * 0.5f) * 0.0515f, radius, 1.0f, 0.0f, 0.0f));
+            }
+        }
+    }
+
+    // FNV-1a step over one 64-bit value
+    static uint64_t combine(uint64_t hash, uint64_t value) {
+        for (int byte = 0; byte < 8; ++byte) {
+            hash ^= (value >> (8 * byte)) & 0xff;
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    int physics() {
+        Table table(-1.5f, 1.5f, 0.8f, -0.8f);
+        GridBroadphase broadphase;
+        Narrowphase narrowphase;
+        BallSystem balls;
+
+        uint64_t hash = 14695981039346656037ULL;
+        long steps = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int shot = 0; shot < PHYSICS_SHOTS; ++shot) {
+            setupRack(balls);
+            Physics::applyShot(balls, Physics::Shot{ 0, -0.6f + shot * 0.006f, 5.0f });
+            for (int step = 0; step < PHYSICS_MAX_STEPS && !balls.awakeBalls().empty(); ++step) {
+                Physics::updatePhysics(balls, table, PHYSICS_DT, broadphase, narrowphase);
+                ++steps;
+            }
+            hash = combine(hash, balls.stateHash());
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+#ifdef PHYSICS_FIXED_POINT
+        const char* mode = "fixed point";
+#else
+        const char* mode = "float";
+#endif
+        std::printf("Physics (%s): %d shots, %ld steps, hash %016llx, %.2f us/step\n",
+            mode, PHYSICS_SHOTS, steps, (unsigned long long)hash, seconds / steps * 1e6);
+        return 0;
+    }
+
+    // Cue ball and count - 1 balls on a loose grid, so a large system settles quickly
+    static void setupGrid(BallSystem& balls, int count) {
+        const float radius = 0.025f;
+        balls.clear();
+        balls.add(Ball(-0.4f, 0.0f, radius, 1.0f, 1.0f, 1.0f, true));
+        for (int k = 1; k < count; ++k) {
+            balls.add(Ball(-1.2f + (k % 8) * 0.3f, -0.5f + (k / 8) * 0.3f, radius, 1.0f, 0.0f, 0.0f));
+        }
+    }
+
+    static double nanoseconds(std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end, int iterations) {
+        return std::chrono::duration<double>(end - begin).count() / iterations * 1e9;
+    }
+
+    int snapshot() {
+        Table table(-1.5f, 1.5f, 0.8f, -0.8f);
+        GridBroadphase broadphase;
+        Narrowphase narrowphase;
+
+        const int counts[] = { 16, 256 };
+        for (int count : counts) {
+            BallSystem balls;
+            setupGrid(balls, count);
+            Physics::runToRest(balls, table, PHYSICS_DT, broadphase, narrowphase);
+            Snapshot snapshot(count);
+
+            auto start = std::chrono::steady_clock::now();
+            for (int k = 0; k < SNAPSHOT_ITERATIONS; ++k) snapshot.capture(balls);
+            auto captured = std::chrono::steady_clock::now();
+            for (int k = 0; k < SNAPSHOT_ITERATIONS; ++k) snapshot.restoreAll(balls);
+            auto restoredAll = std::chrono::steady_clock::now();
+            for (int k = 0; k < SNAPSHOT_ITERATIONS; ++k) {
+                balls.wake(0);
+                snapshot.restore(balls);
+            }
+            auto restored = std::chrono::steady_clock::now();
+
+            // A copy into a fresh system pays for the allocations Snapshot avoids
+            BallSystem copy;
+            for (int k = 0; k < SNAPSHOT_ITERATIONS / 10; ++k) {
+                copy = BallSystem();
+                copy = balls;
+            }
+            auto copied = std::chrono::steady_clock::now();
+
+            std::printf("Snapshot, %d balls: capture %.1f ns, restoreAll %.1f ns, restore (1 ball woken) %.1f ns, BallSystem copy %.1f ns\n",
+                count, nanoseconds(start, captured, SNAPSHOT_ITERATIONS), nanoseconds(captured, restoredAll, SNAPSHOT_ITERATIONS),
+                nanoseconds(restoredAll, restored, SNAPSHOT_ITERATIONS), nanoseconds(restored, copied, SNAPSHOT_ITERATIONS / 10));
+        }
+        return 0;
+    }
+}
@@ -0,0 +1,19 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+// Merenja bez prozora, za poredjenje buildova (Main.cpp: --bench-physics, --bench-snapshot).
+// Ispis je tekst na stdout; vracaju 0 kao kod izlaza programa.
+namespace Benchmark {
+    // 200 udaraca u trougao od 15 kugli (16 sa belom), korak 1/240 s sa grid grubom
+    // fazom, do mirovanja ili 20 s. Ispisuje rezim (float ili fiksna tacka), zbirni
+    // BallSystem::stateHash svih udaraca i us po koraku. Sa PHYSICS_FIXED_POINT hash
+    // mora biti isti za svaki build (-O0, -O3, -march=native, /fp:fast...); float
+    // build daje referentno vreme za poredjenje cene fiksne tacke.
+    int physics();
+
+    // Cena Snapshot-a za 16 i 256 kugli u ns: capture, restoreAll, restore kad je
+    // promenjena jedna kugla i, poredjenja radi, kopija celog BallSystem-a
+    int snapshot();
+}
+
+#endif
@@ -0,0 +1,68 @@
+#include "BoundaryField.h"
+#include "SegmentBVH.h"
+#include <cmath>
+
+const float BoundaryField::CELL = 0.01f;
+
+BoundaryField::BoundaryField(const Table& table) {
+    const SegmentBVH& tree = table.getCushionTree();
+
+    // The grid covers the table, every pocket circle and every cushion, with two spare cells
+    float minX = table.left, maxX = table.right, minY = table.bottom, maxY = table.top;
+    for (const Pocket& pocket : table.pockets) {
+        minX = std::min(minX, pocket.x - pocket.radius);
+        maxX = std::max(maxX, pocket.x + pocket.radius);
+        minY = std::min(minY, pocket.y - pocket.radius);
+        maxY = std::max(maxY, pocket.y + pocket.radius);
+    }
+    for (const CushionSegment& s : tree.getSegments()) {
+        minX = std::min(minX, std::min(s.x0, s.x1));
+        maxX = std::max(maxX, std::max(s.x0, s.x1));
+        minY = std::min(minY, std::min(s.y0, s.y1));
+        maxY = std::max(maxY, std::max(s.y0, s.y1));
+    }
+    // Sizes in double, so a span that is a whole number of cells cannot round either way
+    originX = minX - 2.0f * CELL;
+    originY = minY - 2.0f * CELL;
+    inverseCell = 1.0f / CELL;
+    columns = (int)std::ceil((maxX - minX) / (double)CELL) + 5;
+    rows = (int)std::ceil((maxY - minY) / (double)CELL) + 5;
+    maxColumn = (float)(columns - 1) - 0.001f;
+    maxRow = (float)(rows - 1) - 0.001f;
+
+    distance.resize((size_t)columns * rows);
+    normalX.resize(distance.size());
+    normalY.resize(distance.size());
+
+    for (int row = 0; row < rows; ++row) {
+        for (int column = 0; column < columns; ++column) {
+            double px = (double)originX + column * (double)CELL;
+            double py = (double)originY + row * (double)CELL;
+            size_t k = (size_t)row * columns + column;
+
+            // Without cushions everything is cloth
+            SegmentHit nearest = tree.nearest(px, py);
+            if (nearest.segment < 0) {
+                distance[k] = -1000.0f;
+                normalX[k] = normalY[k] = 0.0f;
+                continue;
+            }
+
+            // The side comes from the normal at the nearest point; at a vertex that is the
+            // pseudo-normal, which tells the inside of a corner from the outside
+            double side = (px - nearest.x) * nearest.nx + (py - nearest.y) * nearest.ny;
+            double sign = side > 0.0 ? 1.0 : -1.0;
+            double nx = nearest.nx, ny = nearest.ny;
+            if (nearest.distance > 1e-9) {
+                nx = sign * (px - nearest.x) / nearest.distance;
+                ny = sign * (py - nearest.y) / nearest.distance;
+            }
+
+            // Positive in the cushion; the normal points from the cloth into the cushion.
+            // Everything up to here is double, so the rounding to Real is the same on every build.
+            distance[k] = (Real)(sign * nearest.distance);
+            normalX[k] = (Real)nx;
+            normalY[k] = (Real)ny;
+        }
+    }
+}
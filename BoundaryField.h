@@ -0,0 +1,80 @@
+#ifndef BOUNDARY_FIELD_H
+#define BOUNDARY_FIELD_H
+
+#include "Table.h"
+#include "Real.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Rastojanje tacke od ivice igracke povrsine (pozitivno u gumi, negativno na
+// tkanini) i jedinicna normala ka gumi
+struct BoundarySample {
+    Real distance;
+    Real nx, ny;
+};
+
+// Ispecena funkcija rastojanja (SDF) za gume stola (Table::cushions, sa kosim
+// celima oko usta dzepova). Rastojanje i normala se racunaju tacno u cvorovima
+// mreze pri pravljenju Table-a, preko najblize ivice iz SegmentBVH; kugla
+// proverava ivicu jednim bilinearnim citanjem. Kontakt postoji kad je
+// distance + radius > 0. Mreza i citanje su u Real, pa je i ovaj deo koraka
+// deterministican sa PHYSICS_FIXED_POINT.
+class BoundaryField {
+public:
+    // Razmak cvorova mreze (jedinica); na pravim gumama interpolacija je tacna
+    static const float CELL;
+
+    explicit BoundaryField(const Table& table);
+
+    BoundarySample sample(Real x, Real y) const;
+
+    // Za SIMD citanje (AVX2 gather): cvor (column, row) je na indeksu row * columns + column
+    int getColumns() const { return columns; }
+    int getRows() const { return rows; }
+    float getOriginX() const { return toFloat(originX); }
+    float getOriginY() const { return toFloat(originY); }
+    float getInverseCell() const { return toFloat(inverseCell); }
+    float getMaxColumn() const { return toFloat(maxColumn); }
+    float getMaxRow() const { return toFloat(maxRow); }
+    const Real* getDistances() const { return distance.data(); }
+    const Real* getNormalsX() const { return normalX.data(); }
+    const Real* getNormalsY() const { return normalY.data(); }
+
+private:
+    int columns, rows;
+    Real originX, originY, inverseCell;
+    Real maxColumn, maxRow;     // najveca koordinata u mrezi za koju postoji i susedni cvor
+    std::vector<Real> distance, normalX, normalY;
+};
+
+// Koordinate se odsecaju na mrezu, pa tacka van nje dobija vrednost ivice mreze.
+// LaneStepper::stepAVX2 ponavlja iste operacije istim redom.
+inline BoundarySample BoundaryField::sample(Real x, Real y) const {
+    Real gx = std::min(std::max((x - originX) * inverseCell, Real(0.0f)), maxColumn);
+    Real gy = std::min(std::max((y - originY) * inverseCell, Real(0.0f)), maxRow);
+    int column = toInt(gx);
+    int row = toInt(gy);
+    Real fx = gx - Real(column);
+    Real fy = gy - Real(row);
+
+    int k = row * columns + column;
+    int above = k + columns;
+    auto bilinear = [&](const std::vector<Real>& v) {
+        Real bottom = v[k] + (v[k + 1] - v[k]) * fx;
+        Real top = v[above] + (v[above + 1] - v[above]) * fx;
+        return bottom + (top - bottom) * fy;
+    };
+
+    BoundarySample result;
+    result.distance = bilinear(distance);
+    Real nx = bilinear(normalX);
+    Real ny = bilinear(normalY);
+    Real length = realSqrt(nx * nx + ny * ny);
+    Real scale = length > 0.0f ? Real(1.0f) / length : Real(0.0f);
+    result.nx = nx * scale;
+    result.ny = ny * scale;
+    return result;
+}
+
+#endif
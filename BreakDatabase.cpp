@@ -0,0 +1,361 @@
+#include "BreakDatabase.h"
+#include "Header/Util.h"
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+// On-disk header; every field is 4 or 8 bytes and naturally aligned, so there is no padding
+struct BreakDatabaseHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t ballCount;
+    uint32_t cueBall;
+    uint32_t count[BreakGrid::AXES];
+    float minValue[BreakGrid::AXES];
+    float maxValue[BreakGrid::AXES];
+    float apexX, apexY;
+    float left, right, top, bottom;
+    uint32_t recordSize;
+    uint64_t rackHash;
+    float friction, collisionDamping;
+    uint64_t tableHash;
+};
+
+static_assert(sizeof(BreakDatabaseHeader) == 120, "BreakDatabaseHeader layout is part of the file format");
+
+static const char BREAK_MAGIC[8] = { 'K', 'B', 'R', 'E', 'A', 'K', 'D', 'B' };
+static const uint32_t BREAK_VERSION = 4;
+
+// Tables per BatchSimulator run while building
+static const size_t BUILD_CHUNK = 4096;
+
+BreakGrid::BreakGrid() {
+    count[CueX] = 6;   minValue[CueX] = -0.7f;   maxValue[CueX] = -0.2f;
+    count[CueY] = 9;   minValue[CueY] = -0.4f;   maxValue[CueY] = 0.4f;
+    count[Angle] = 33; minValue[Angle] = -0.08f; maxValue[Angle] = 0.08f;
+    count[Power] = 15; minValue[Power] = 1.0f;   maxValue[Power] = 7.2f;
+}
+
+static float axisValue(const BreakGrid& grid, int axis, int index) {
+    if (grid.count[axis] < 2) return grid.minValue[axis];
+    return grid.minValue[axis] + (grid.maxValue[axis] - grid.minValue[axis]) * index / (grid.count[axis] - 1);
+}
+
+static const uint64_t HASH_START = 14695981039346656037ULL;
+
+// FNV-1a over the bytes of one float
+static void mixHash(uint64_t& hash, float value) {
+    unsigned char bytes[4];
+    std::memcpy(bytes, &value, 4);
+    for (unsigned char byte : bytes) {
+        hash ^= byte;
+        hash *= 1099511628211ULL;
+    }
+}
+
+// Identifies the object balls of the rack; the cue position is part of the grid, not the hash
+static uint64_t rackHash(const BallSystem& rack, int cueBall) {
+    uint64_t hash = HASH_START;
+    auto mix = [&hash](float value) { mixHash(hash, value); };
+
+    mix((float)rack.size());
+    for (size_t i = 0; i < rack.size(); ++i) {
+        if ((int)i == cueBall) continue;
+        mix(toFloat(rack.x[i]));
+        mix(toFloat(rack.y[i]));
+        mix(toFloat(rack.radius[i]));
+        mix(rack.active[i] ? 1.0f : 0.0f);
+    }
+    return hash;
+}
+
+// Identifies the table geometry the outcomes were simulated on: pockets and cushion outlines
+// (the bounds are stored in the header on their own)
+static uint64_t tableHash(const Table& table) {
+    uint64_t hash = HASH_START;
+    auto mix = [&hash](float value) { mixHash(hash, value); };
+
+    mix((float)table.pockets.size());
+    for (const Pocket& pocket : table.pockets) {
+        mix(pocket.x);
+        mix(pocket.y);
+        mix(pocket.radius);
+    }
+    mix((float)table.cushions.size());
+    for (const Cushion& cushion : table.cushions) {
+        mix((float)cushion.points.size());
+        for (const CushionPoint& point : cushion.points) {
+            mix(point.x);
+            mix(point.y);
+        }
+    }
+    return hash;
+}
+
+// Object ball nearest the middle of the cue grid - the ball a straight break aims at
+static int findApex(const BallSystem& rack, int cueBall, const BreakGrid& grid) {
+    float cx = (grid.minValue[BreakGrid::CueX] + grid.maxValue[BreakGrid::CueX]) * 0.5f;
+    float cy = (grid.minValue[BreakGrid::CueY] + grid.maxValue[BreakGrid::CueY]) * 0.5f;
+    int apex = -1;
+    float nearest = 0.0f;
+    for (size_t i = 0; i < rack.size(); ++i) {
+        if ((int)i == cueBall || !rack.active[i]) continue;
+        float dist = distance(cx, cy, toFloat(rack.x[i]), toFloat(rack.y[i]));
+        if (apex < 0 || dist < nearest) {
+            apex = (int)i;
+            nearest = dist;
+        }
+    }
+    return apex;
+}
+
+static uint16_t quantizePosition(float value, float origin, float scale) {
+    float steps = std::floor((value - origin) * scale + 0.5f);
+    steps = steps < 0.0f ? 0.0f : (steps > 65535.0f ? 65535.0f : steps);
+    return (uint16_t)steps;
+}
+
+bool BreakDatabase::build(const std::string& path, const BallSystem& rack, int cueBall,
+    const Table& table, const BreakGrid& grid, BatchSimulator& batch) {
+    if (rack.size() > (size_t)BreakOutcome::MAX_BALLS || cueBall < 0 || cueBall >= (int)rack.size()) return false;
+    int apex = findApex(rack, cueBall, grid);
+    if (apex < 0) return false;
+
+    BreakDatabaseHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, BREAK_MAGIC, sizeof(BREAK_MAGIC));
+    header.version = BREAK_VERSION;
+    header.ballCount = (uint32_t)rack.size();
+    header.cueBall = (uint32_t)cueBall;
+    for (int axis = 0; axis < BreakGrid::AXES; ++axis) {
+        header.count[axis] = (uint32_t)grid.count[axis];
+        header.minValue[axis] = grid.minValue[axis];
+        header.maxValue[axis] = grid.maxValue[axis];
+    }
+    header.apexX = toFloat(rack.x[apex]);
+    header.apexY = toFloat(rack.y[apex]);
+    header.left = table.left;
+    header.right = table.right;
+    header.top = table.top;
+    header.bottom = table.bottom;
+    header.recordSize = (uint32_t)(4 + 4 * rack.size());
+    header.rackHash = rackHash(rack, cueBall);
+    header.friction = table.physics.friction;
+    header.collisionDamping = table.physics.collisionDamping;
+    header.tableHash = tableHash(table);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    const float scaleX = 65535.0f / (table.right - table.left);
+    const float scaleY = 65535.0f / (table.top - table.bottom);
+
+    std::vector<BallSystem> states;
+    std::vector<Physics::Shot> shots;
+    std::vector<unsigned char> records;
+    const size_t cells = grid.cellCount();
+
+    for (size_t begin = 0; begin < cells; begin += BUILD_CHUNK) {
+        size_t end = begin + BUILD_CHUNK < cells ? begin + BUILD_CHUNK : cells;
+        states.assign(end - begin, rack);
+        shots.resize(end - begin);
+
+        // Row-major over (cueX, cueY, angle, power), power fastest
+        for (size_t cell = begin; cell < end; ++cell) {
+            size_t rest = cell;
+            int power = (int)(rest % grid.count[BreakGrid::Power]); rest /= grid.count[BreakGrid::Power];
+            int angle = (int)(rest % grid.count[BreakGrid::Angle]); rest /= grid.count[BreakGrid::Angle];
+            int cueY = (int)(rest % grid.count[BreakGrid::CueY]); rest /= grid.count[BreakGrid::CueY];
+            int cueX = (int)rest;
+
+            BallSystem& balls = states[cell - begin];
+            float x = axisValue(grid, BreakGrid::CueX, cueX);
+            float y = axisValue(grid, BreakGrid::CueY, cueY);
+            balls.x[cueBall] = x;
+            balls.y[cueBall] = y;
+            balls.snapPrevious(cueBall);
+
+            float straight = std::atan2(header.apexY - y, header.apexX - x);
+            shots[cell - begin] = Physics::Shot{ cueBall,
+                straight + axisValue(grid, BreakGrid::Angle, angle),
+                axisValue(grid, BreakGrid::Power, power) };
+        }
+
+        batch.run(states, shots, table);
+
+        records.assign((end - begin) * header.recordSize, 0);
+        for (size_t k = 0; k < states.size(); ++k) {
+            const BallSystem& balls = states[k];
+            unsigned char* data = &records[k * header.recordSize];
+
+            uint32_t pocketedMask = 0;
+            for (size_t i = 0; i < balls.size(); ++i) {
+                if (rack.active[i] && !balls.active[i]) pocketedMask |= 1u << i;
+            }
+            std::memcpy(data, &pocketedMask, 4);
+
+            for (size_t i = 0; i < balls.size(); ++i) {
+                uint16_t position[2] = {
+                    quantizePosition(toFloat(balls.x[i]), table.left, scaleX),
+                    quantizePosition(toFloat(balls.y[i]), table.bottom, scaleY)
+                };
+                std::memcpy(data + 4 + 4 * i, position, 4);
+            }
+        }
+        out.write(reinterpret_cast<const char*>(records.data()), records.size());
+    }
+
+    return (bool)out;
+}
+
+BreakDatabase::BreakDatabase()
+    : ballCount(0), cueBall(0), recordSize(0), apexX(0.0f), apexY(0.0f),
+    left(0.0f), bottom(0.0f), positionStepX(0.0f), positionStepY(0.0f) {}
+
+bool BreakDatabase::open(const std::string& path, const BallSystem& rack, const Table& table) {
+    close();
+    if (!file.open(path)) return false;
+
+    BreakDatabaseHeader header;
+    bool valid = file.getSize() >= sizeof(header);
+    if (valid) {
+        std::memcpy(&header, file.getData(), sizeof(header));
+        valid = std::memcmp(header.magic, BREAK_MAGIC, sizeof(BREAK_MAGIC)) == 0 &&
+            header.version == BREAK_VERSION &&
+            header.ballCount == rack.size() &&
+            header.ballCount <= (uint32_t)BreakOutcome::MAX_BALLS &&
+            header.recordSize == 4 + 4 * header.ballCount &&
+            header.rackHash == rackHash(rack, (int)header.cueBall) &&
+            header.left == table.left && header.right == table.right &&
+            header.top == table.top && header.bottom == table.bottom &&
+            header.tableHash == tableHash(table) &&
+            header.friction == table.physics.friction &&
+            header.collisionDamping == table.physics.collisionDamping;
+    }
+    if (valid) {
+        for (int axis = 0; axis < BreakGrid::AXES; ++axis) {
+            grid.count[axis] = (int)header.count[axis];
+            grid.minValue[axis] = header.minValue[axis];
+            grid.maxValue[axis] = header.maxValue[axis];
+            if (grid.count[axis] < 1) valid = false;
+        }
+    }
+    if (valid) valid = file.getSize() == sizeof(header) + grid.cellCount() * header.recordSize;
+    if (!valid) {
+        close();
+        return false;
+    }
+
+    ballCount = (int)header.ballCount;
+    cueBall = (int)header.cueBall;
+    recordSize = header.recordSize;
+    apexX = header.apexX;
+    apexY = header.apexY;
+    left = header.left;
+    bottom = header.bottom;
+    positionStepX = (header.right - header.left) / 65535.0f;
+    positionStepY = (header.top - header.bottom) / 65535.0f;
+    return true;
+}
+
+void BreakDatabase::close() {
+    file.close();
+}
+
+void BreakDatabase::gridCoordinates(float cueX, float cueY, float angle, float power, float* coordinates) const {
+    // Angle relative to the straight line at the apex, wrapped to [-pi, pi]
+    float offset = angle - std::atan2(apexY - cueY, apexX - cueX);
+    offset = std::atan2(std::sin(offset), std::cos(offset));
+
+    float values[BreakGrid::AXES] = { cueX, cueY, offset, power };
+    for (int axis = 0; axis < BreakGrid::AXES; ++axis) {
+        float range = grid.maxValue[axis] - grid.minValue[axis];
+        float t = range > 0.0f ? (values[axis] - grid.minValue[axis]) / range : 0.0f;
+        coordinates[axis] = clamp(t, 0.0f, 1.0f) * (grid.count[axis] - 1);
+    }
+}
+
+const unsigned char* BreakDatabase::record(const int* cell) const {
+    size_t index = (size_t)cell[BreakGrid::CueX];
+    index = index * grid.count[BreakGrid::CueY] + cell[BreakGrid::CueY];
+    index = index * grid.count[BreakGrid::Angle] + cell[BreakGrid::Angle];
+    index = index * grid.count[BreakGrid::Power] + cell[BreakGrid::Power];
+    return file.getData() + sizeof(BreakDatabaseHeader) + index * recordSize;
+}
+
+void BreakDatabase::decodeRecord(const unsigned char* data, BreakOutcome& outcome) const {
+    outcome.ballCount = ballCount;
+    std::memcpy(&outcome.pocketedMask, data, 4);
+    for (int i = 0; i < ballCount; ++i) {
+        uint16_t position[2];
+        std::memcpy(position, data + 4 + 4 * i, 4);
+        outcome.x[i] = left + position[0] * positionStepX;
+        outcome.y[i] = bottom + position[1] * positionStepY;
+    }
+}
+
+bool BreakDatabase::lookup(float cueX, float cueY, float angle, float power, BreakOutcome& outcome) const {
+    if (!isOpen()) return false;
+
+    float coordinates[BreakGrid::AXES];
+    gridCoordinates(cueX, cueY, angle, power, coordinates);
+
+    int cell[BreakGrid::AXES];
+    for (int axis = 0; axis < BreakGrid::AXES; ++axis) {
+        cell[axis] = (int)std::floor(coordinates[axis] + 0.5f);
+    }
+    decodeRecord(record(cell), outcome);
+    return true;
+}
+
+bool BreakDatabase::estimate(float cueX, float cueY, float angle, float power, BreakEstimate& estimate) const {
+    if (!isOpen()) return false;
+
+    float coordinates[BreakGrid::AXES];
+    gridCoordinates(cueX, cueY, angle, power, coordinates);
+
+    int base[BreakGrid::AXES];
+    float fraction[BreakGrid::AXES];
+    for (int axis = 0; axis < BreakGrid::AXES; ++axis) {
+        base[axis] = (int)std::floor(coordinates[axis]);
+        if (base[axis] >= grid.count[axis] - 1) base[axis] = grid.count[axis] > 1 ? grid.count[axis] - 2 : 0;
+        fraction[axis] = grid.count[axis] > 1 ? coordinates[axis] - base[axis] : 0.0f;
+    }
+
+    std::memset(&estimate, 0, sizeof(estimate));
+    float cueWeight = 0.0f;
+    BreakOutcome corner;
+
+    // Multilinear blend of the 16 surrounding cells
+    for (int mask = 0; mask < (1 << BreakGrid::AXES); ++mask) {
+        int cell[BreakGrid::AXES];
+        float weight = 1.0f;
+        for (int axis = 0; axis < BreakGrid::AXES; ++axis) {
+            bool upper = (mask >> axis & 1) != 0;
+            cell[axis] = base[axis] + (upper && grid.count[axis] > 1 ? 1 : 0);
+            weight *= upper ? fraction[axis] : 1.0f - fraction[axis];
+        }
+        if (weight == 0.0f) continue;
+
+        decodeRecord(record(cell), corner);
+        for (int i = 0; i < ballCount; ++i) {
+            if (corner.isPocketed(i)) estimate.pocketProbability[i] += weight;
+        }
+        if (!corner.isPocketed(cueBall)) {
+            estimate.cueX += corner.x[cueBall] * weight;
+            estimate.cueY += corner.y[cueBall] * weight;
+            cueWeight += weight;
+        }
+    }
+
+    for (int i = 0; i < ballCount; ++i) {
+        if (i != cueBall) estimate.expectedPocketed += estimate.pocketProbability[i];
+    }
+    estimate.scratchProbability = estimate.pocketProbability[cueBall];
+    if (cueWeight > 0.0f) {
+        estimate.cueX /= cueWeight;
+        estimate.cueY /= cueWeight;
+    }
+    return true;
+}
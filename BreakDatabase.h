@@ -0,0 +1,86 @@
+#ifndef BREAK_DATABASE_H
+#define BREAK_DATABASE_H
+
+#include "BatchSimulator.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <string>
+
+// Mreza pocetnih udaraca: pozicija bele (x, y) x ugao x jacina. Ugao je odstupanje
+// (radijani) od pravca bela -> prva kugla trougla, pa je pravo u trougao uvek 0.
+struct BreakGrid {
+    enum Axis { CueX, CueY, Angle, Power, AXES };
+
+    int count[AXES];
+    float minValue[AXES];
+    float maxValue[AXES];
+
+    // Podrazumevana mreza za sto i trougao iz Main.cpp (~27k udaraca)
+    BreakGrid();
+
+    size_t cellCount() const { return (size_t)count[CueX] * count[CueY] * count[Angle] * count[Power]; }
+};
+
+// Ishod jednog udarca iz baze (najblize polje mreze)
+struct BreakOutcome {
+    static const int MAX_BALLS = 32;
+
+    int ballCount;
+    uint32_t pocketedMask;         // bit i = kugla i je upala (ukljucujuci belu)
+    float x[MAX_BALLS], y[MAX_BALLS];
+
+    bool isPocketed(int i) const { return (pocketedMask >> i & 1u) != 0; }
+};
+
+// Interpolirana procena izmedju 16 susednih polja mreze
+struct BreakEstimate {
+    float pocketProbability[BreakOutcome::MAX_BALLS];
+    float expectedPocketed;        // ocekivan broj upalih kugli osim bele
+    float scratchProbability;
+    float cueX, cueY;              // konacna pozicija bele kad ne upadne
+};
+
+// Baza ishoda pocetnog udarca. Trougao iz setupBalls je uvek isti, pa se ishodi za
+// celu mrezu racunaju jednom (build, paralelno preko BatchSimulator-a) i pisu u
+// binarni fajl: zaglavlje pa zapisi fiksne velicine redom po mrezi, tako da je
+// indeks zapisa izracunljiv iz koordinata. Igra i botovi otvaraju fajl preko
+// mmap, a pretraga je O(1) bez ucitavanja celog fajla.
+//
+// Zapis: maska upalih kugli (32 bita) i konacne pozicije svih kugli, 16 bita po
+// osi relativno na ivice stola. Fajl je little-endian.
+class BreakDatabase {
+public:
+    BreakDatabase();
+
+    // Racuna sve udarce mreze za raspored rack (bela je cueBall) i pise fajl
+    static bool build(const std::string& path, const BallSystem& rack, int cueBall,
+        const Table& table, const BreakGrid& grid, BatchSimulator& batch);
+
+    // Otvara fajl; odbija ga ako je pravljen za drugi raspored kugli, drugi sto
+    // (dimenzije, dzepovi, gume) ili druge parametre fizike
+    bool open(const std::string& path, const BallSystem& rack, const Table& table);
+    void close();
+    bool isOpen() const { return file.isOpen(); }
+
+    // angle je apsolutni ugao udarca (kao Physics::Shot). Van mreze se uzima ivica.
+    bool lookup(float cueX, float cueY, float angle, float power, BreakOutcome& outcome) const;
+    bool estimate(float cueX, float cueY, float angle, float power, BreakEstimate& estimate) const;
+
+    const BreakGrid& getGrid() const { return grid; }
+
+private:
+    // Koordinate u mrezi (neceli indeksi) za zadati udarac
+    void gridCoordinates(float cueX, float cueY, float angle, float power, float* coordinates) const;
+    const unsigned char* record(const int* cell) const;
+    void decodeRecord(const unsigned char* data, BreakOutcome& outcome) const;
+
+    MappedFile file;
+    BreakGrid grid;
+    int ballCount;
+    int cueBall;
+    size_t recordSize;
+    float apexX, apexY;
+    float left, bottom, positionStepX, positionStepY;
+};
+
+#endif
@@ -0,0 +1,197 @@
+#include "Broadphase.h"
+#include <algorithm>
+#include <cmath>
+
+const std::vector<BallPair>& BruteForceBroadphase::findPairs(const BallSystem& balls, const Table& /*table*/) {
+    pairs.clear();
+
+    for (size_t i = 0; i < balls.size(); ++i) {
+        if (!balls.active[i]) continue;
+        for (size_t j = i + 1; j < balls.size(); ++j) {
+            if (!balls.active[j]) continue;
+            if (balls.asleep[i] && balls.asleep[j]) continue;
+            pairs.push_back(BallPair((int)i, (int)j));
+        }
+    }
+
+    return pairs;
+}
+
+// Cell count per axis is capped so tiny radii on a big table don't blow up memory
+static const int MAX_GRID_CELLS_PER_AXIS = 512;
+
+void GridBroadphase::setupGrid(const BallSystem& balls, const Table& table) {
+    float maxRadius = 0.0f;
+    for (size_t i = 0; i < balls.size(); ++i) {
+        if (balls.active[i] && toFloat(balls.radius[i]) > maxRadius) maxRadius = toFloat(balls.radius[i]);
+    }
+    if (maxRadius <= 0.0f) maxRadius = 0.03f;
+
+    // Contact distance (2r) plus one radius of slack for the positional correction
+    // done in handleBallCollision, so pairs pushed together during the same step
+    // are still candidates.
+    float width = table.right - table.left;
+    float height = table.top - table.bottom;
+    cellSize = std::max(maxRadius * 3.0f, std::max(width, height) / MAX_GRID_CELLS_PER_AXIS);
+
+    originX = table.left;
+    originY = table.bottom;
+    cols = std::max(1, (int)std::ceil(width / cellSize));
+    rows = std::max(1, (int)std::ceil(height / cellSize));
+}
+
+int GridBroadphase::cellCoord(float value, float origin, int cellCount) const {
+    // Balls near pockets can leave the table bounds - clamp them to the border cells
+    int c = (int)std::floor((value - origin) / cellSize);
+    if (c < 0) return 0;
+    if (c >= cellCount) return cellCount - 1;
+    return c;
+}
+
+const std::vector<BallPair>& GridBroadphase::findPairs(const BallSystem& balls, const Table& table) {
+    pairs.clear();
+    setupGrid(balls, table);
+
+    int cellCount = cols * rows;
+    cellStart.assign(cellCount + 1, 0);
+    ballCell.resize(balls.size());
+
+    for (size_t i = 0; i < balls.size(); ++i) {
+        if (!balls.active[i]) {
+            ballCell[i] = -1;
+            continue;
+        }
+        int cx = cellCoord(toFloat(balls.x[i]), originX, cols);
+        int cy = cellCoord(toFloat(balls.y[i]), originY, rows);
+        ballCell[i] = cy * cols + cx;
+        cellStart[ballCell[i] + 1]++;
+    }
+
+    for (int c = 0; c < cellCount; ++c) {
+        cellStart[c + 1] += cellStart[c];
+    }
+
+    cellBalls.resize(cellStart[cellCount]);
+    cellCursor.assign(cellStart.begin(), cellStart.end() - 1);
+    for (size_t i = 0; i < balls.size(); ++i) {
+        if (ballCell[i] < 0) continue;
+        cellBalls[cellCursor[ballCell[i]]++] = (int)i;
+    }
+
+    // Only awake balls look around; a sleeping neighbour is paired from the
+    // awake side, two awake balls from the lower index
+    for (int i : balls.awakeBalls()) {
+        int cx = ballCell[i] % cols;
+        int cy = ballCell[i] / cols;
+
+        for (int ny = std::max(cy - 1, 0); ny <= std::min(cy + 1, rows - 1); ++ny) {
+            for (int nx = std::max(cx - 1, 0); nx <= std::min(cx + 1, cols - 1); ++nx) {
+                int cell = ny * cols + nx;
+                for (int k = cellStart[cell]; k < cellStart[cell + 1]; ++k) {
+                    int j = cellBalls[k];
+                    if (j > i) pairs.push_back(BallPair(i, j));
+                    else if (j < i && balls.asleep[j]) pairs.push_back(BallPair(j, i));
+                }
+            }
+        }
+    }
+
+    // Keep the brute force (i, j) order - resolution order affects the result
+    std::sort(pairs.begin(), pairs.end(), [](const BallPair& a, const BallPair& b) {
+        return a.i != b.i ? a.i < b.i : a.j < b.j;
+    });
+
+    return pairs;
+}
+
+// Same slack as the grid cell: one extra radius for positional correction
+static float sweepExtent(float radius) {
+    return radius * 1.5f;
+}
+
+static bool endpointLess(float aValue, bool aIsMin, float bValue, bool bIsMin) {
+    // Starts sort before ends at the same coordinate so touching intervals overlap
+    if (aValue != bValue) return aValue < bValue;
+    return aIsMin && !bIsMin;
+}
+
+void SweepAndPruneBroadphase::rebuildEndpoints(const BallSystem& balls) {
+    endpoints.clear();
+    for (size_t i = 0; i < balls.size(); ++i) {
+        endpoints.push_back(Endpoint{ 0.0f, (int)i, true });
+        endpoints.push_back(Endpoint{ 0.0f, (int)i, false });
+    }
+    openIndex.assign(balls.size(), -1);
+}
+
+void SweepAndPruneBroadphase::updateEndpoints(const BallSystem& balls) {
+    for (auto& endpoint : endpoints) {
+        int i = endpoint.ball;
+        float x = toFloat(balls.x[i]);
+        float extent = sweepExtent(toFloat(balls.radius[i]));
+        endpoint.value = endpoint.isMin ? x - extent : x + extent;
+    }
+}
+
+void SweepAndPruneBroadphase::insertionSort() {
+    for (size_t i = 1; i < endpoints.size(); ++i) {
+        Endpoint key = endpoints[i];
+        size_t j = i;
+        while (j > 0 && endpointLess(key.value, key.isMin, endpoints[j - 1].value, endpoints[j - 1].isMin)) {
+            endpoints[j] = endpoints[j - 1];
+            --j;
+        }
+        endpoints[j] = key;
+    }
+}
+
+const std::vector<BallPair>& SweepAndPruneBroadphase::findPairs(const BallSystem& balls, const Table& /*table*/) {
+    pairs.clear();
+
+    if (endpoints.size() != balls.size() * 2) {
+        rebuildEndpoints(balls);
+    }
+    updateEndpoints(balls);
+    insertionSort();
+
+    open.clear();
+    for (const auto& endpoint : endpoints) {
+        int b = endpoint.ball;
+        if (!balls.active[b]) continue;
+
+        if (endpoint.isMin) {
+            for (int other : open) {
+                if (balls.asleep[b] && balls.asleep[other]) continue;
+                pairs.push_back(b < other ? BallPair(b, other) : BallPair(other, b));
+            }
+            openIndex[b] = (int)open.size();
+            open.push_back(b);
+        }
+        else if (openIndex[b] >= 0) {
+            int last = open.back();
+            open[openIndex[b]] = last;
+            openIndex[last] = openIndex[b];
+            open.pop_back();
+            openIndex[b] = -1;
+        }
+    }
+
+    // Sweep order is by x - restore the brute force (i, j) resolution order
+    std::sort(pairs.begin(), pairs.end(), [](const BallPair& a, const BallPair& b) {
+        return a.i != b.i ? a.i < b.i : a.j < b.j;
+    });
+
+    return pairs;
+}
+
+std::unique_ptr<Broadphase> createBroadphase(BroadphaseType type) {
+    switch (type) {
+    case BroadphaseType::Grid:
+        return std::unique_ptr<Broadphase>(new GridBroadphase());
+    case BroadphaseType::SweepAndPrune:
+        return std::unique_ptr<Broadphase>(new SweepAndPruneBroadphase());
+    case BroadphaseType::BruteForce:
+    default:
+        return std::unique_ptr<Broadphase>(new BruteForceBroadphase());
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef BROADPHASE_H
+#define BROADPHASE_H
+
+#include "BallSystem.h"
+#include "Table.h"
+#include <vector>
+#include <memory>
+
+// Par kugli (i < j) koji ide u proveru sudara
+struct BallPair {
+    int i, j;
+
+    BallPair(int i, int j) : i(i), j(j) {}
+};
+
+enum class BroadphaseType {
+    BruteForce,
+    Grid,
+    SweepAndPrune
+};
+
+// Gruba faza: bira parove kugli koje mogu da se sudare.
+// Parovi se uvek vracaju sortirani po (i, j), istim redom kao brute force petlja,
+// tako da razresavanje sudara daje isti rezultat bez obzira na izabranu metodu.
+// Par dve uspavane kugle se nikad ne vraca.
+class Broadphase {
+public:
+    virtual ~Broadphase() {}
+
+    virtual const std::vector<BallPair>& findPairs(const BallSystem& balls, const Table& table) = 0;
+
+protected:
+    std::vector<BallPair> pairs;
+};
+
+// Svaki par aktivnih kugli - O(n^2)
+class BruteForceBroadphase : public Broadphase {
+public:
+    const std::vector<BallPair>& findPairs(const BallSystem& balls, const Table& table) override;
+};
+
+// Uniformna mreza preko stola; kandidati su samo kugle iz susednih celija
+class GridBroadphase : public Broadphase {
+public:
+    const std::vector<BallPair>& findPairs(const BallSystem& balls, const Table& table) override;
+
+private:
+    void setupGrid(const BallSystem& balls, const Table& table);
+    int cellCoord(float value, float origin, int cellCount) const;
+
+    float originX, originY;
+    float cellSize;
+    int cols, rows;
+
+    std::vector<int> cellStart;   // pocetak svake celije u cellBalls (counting sort)
+    std::vector<int> cellBalls;   // indeksi kugli grupisani po celijama
+    std::vector<int> cellCursor;  // pozicija upisa pri popunjavanju cellBalls
+    std::vector<int> ballCell;    // celija svake kugle, -1 za neaktivne
+};
+
+// Sweep and prune po x osi. Sortirana lista krajeva intervala se cuva izmedju
+// poziva i dosortira insertion sortom - kugle se malo pomere po frejmu pa je to skoro O(n).
+class SweepAndPruneBroadphase : public Broadphase {
+public:
+    const std::vector<BallPair>& findPairs(const BallSystem& balls, const Table& table) override;
+
+private:
+    struct Endpoint {
+        float value;
+        int ball;
+        bool isMin;
+    };
+
+    void rebuildEndpoints(const BallSystem& balls);
+    void updateEndpoints(const BallSystem& balls);
+    void insertionSort();
+
+    std::vector<Endpoint> endpoints;
+    std::vector<int> open;        // kugle ciji je x interval trenutno otvoren u sweep-u
+    std::vector<int> openIndex;   // pozicija kugle u open, -1 ako nije otvorena
+};
+
+std::unique_ptr<Broadphase> createBroadphase(BroadphaseType type);
+
+#endif
@@ -0,0 +1,291 @@
+#include "Calibrator.h"
+#include "Header/Util.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+bool loadTrajectories(const std::string& path, std::vector<ReferenceTrajectory>& trajectories) {
+    FILE* file = std::fopen(path.c_str(), "r");
+    if (!file) return false;
+
+    trajectories.clear();
+    bool valid = true;
+    char line[256];
+    char keyword[32];
+    while (valid && std::fgets(line, sizeof(line), file)) {
+        if (std::sscanf(line, "%31s", keyword) != 1 || keyword[0] == '#') continue;
+
+        if (std::strcmp(keyword, "trajectory") == 0) {
+            trajectories.push_back(ReferenceTrajectory());
+            trajectories.back().shot = Physics::Shot{ 0, 0.0f, 0.0f };
+            continue;
+        }
+        if (trajectories.empty()) {
+            valid = false;
+            break;
+        }
+
+        ReferenceTrajectory& trajectory = trajectories.back();
+        if (std::strcmp(keyword, "ball") == 0) {
+            float x, y, radius;
+            valid = std::sscanf(line, "%*s %f %f %f", &x, &y, &radius) == 3;
+            trajectory.balls.add(Ball(x, y, radius, 1.0f, 1.0f, 1.0f, trajectory.balls.size() == 0));
+        }
+        else if (std::strcmp(keyword, "shot") == 0) {
+            Physics::Shot& shot = trajectory.shot;
+            valid = std::sscanf(line, "%*s %d %f %f", &shot.ball, &shot.angle, &shot.speed) == 3;
+        }
+        else if (std::strcmp(keyword, "sample") == 0) {
+            ReferenceTrajectory::Sample sample;
+            valid = std::sscanf(line, "%*s %f %d %f %f", &sample.time, &sample.ball, &sample.x, &sample.y) == 4;
+            trajectory.samples.push_back(sample);
+        }
+        else {
+            valid = false;
+        }
+    }
+    std::fclose(file);
+    if (!valid) return false;
+
+    // Out of range indices would read past the ball arrays
+    for (ReferenceTrajectory& trajectory : trajectories) {
+        int count = (int)trajectory.balls.size();
+        if (trajectory.shot.ball < 0 || trajectory.shot.ball >= count) return false;
+        for (const ReferenceTrajectory::Sample& sample : trajectory.samples) {
+            if (sample.ball < 0 || sample.ball >= count) return false;
+        }
+        std::stable_sort(trajectory.samples.begin(), trajectory.samples.end(),
+            [](const ReferenceTrajectory::Sample& a, const ReferenceTrajectory::Sample& b) { return a.time < b.time; });
+    }
+    return true;
+}
+
+Calibrator::Calibrator(JobSystem& jobs)
+    : jobs(&jobs), stepDt(1.0f / 240.0f), fitError(0.0), evaluationCount(0) {
+    scratch.resize(jobs.getWorkerCount());
+}
+
+double Calibrator::simulate(int worker, const Table& table, const ReferenceTrajectory& trajectory) {
+    WorkerScratch& local = scratch[worker];
+    BallSystem& balls = local.balls;
+    balls = trajectory.balls;
+
+    size_t n = balls.size();
+    local.lastX.resize(n);
+    local.lastY.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        local.lastX[i] = toFloat(balls.x[i]);
+        local.lastY[i] = toFloat(balls.y[i]);
+    }
+
+    balls.storePreviousPositions();
+    Physics::applyShot(balls, trajectory.shot);
+
+    double sum = 0.0;
+    int steps = 0;
+    for (const ReferenceTrajectory::Sample& sample : trajectory.samples) {
+        while (steps * (double)stepDt < sample.time && !balls.awakeBalls().empty()) {
+            balls.storePreviousPositions();
+            Physics::updatePhysics(balls, table, stepDt, local.broadphase, local.narrowphase);
+            steps++;
+
+            for (int i : balls.awakeBalls()) {
+                local.lastX[i] = toFloat(balls.x[i]);
+                local.lastY[i] = toFloat(balls.y[i]);
+            }
+        }
+
+        // Position at the sample time, between the last two steps. A pocketed ball
+        // counts where it was last seen, so sinking it early costs a finite error.
+        int i = sample.ball;
+        float x = local.lastX[i];
+        float y = local.lastY[i];
+        if (balls.active[i] && steps > 0) {
+            float t = clamp((float)((sample.time - (steps - 1) * (double)stepDt) / stepDt), 0.0f, 1.0f);
+            x = toFloat(balls.prevX[i]) + (toFloat(balls.x[i]) - toFloat(balls.prevX[i])) * t;
+            y = toFloat(balls.prevY[i]) + (toFloat(balls.y[i]) - toFloat(balls.prevY[i])) * t;
+        }
+
+        double dx = x - sample.x;
+        double dy = y - sample.y;
+        sum += dx * dx + dy * dy;
+    }
+    return sum;
+}
+
+void Calibrator::errors(const Table& table, const std::vector<PhysicsParams>& candidates, std::vector<double>& errors) {
+    size_t trajectoryCount = trajectories.size();
+    size_t sampleCount = 0;
+    for (const ReferenceTrajectory& trajectory : trajectories) {
+        sampleCount += trajectory.samples.size();
+    }
+
+    candidateTables.resize(candidates.size(), table);
+    for (size_t c = 0; c < candidates.size(); ++c) {
+        candidateTables[c] = table;
+        candidateTables[c].physics = candidates[c];
+    }
+
+    // One job per (candidate, trajectory); the sum is taken in a fixed order afterwards,
+    // so the result does not depend on how the work was split
+    sums.assign(candidates.size() * trajectoryCount, 0.0);
+    jobs->parallelFor(sums.size(), 1, [this, trajectoryCount](int worker, size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) {
+            sums[k] = simulate(worker, candidateTables[k / trajectoryCount], trajectories[k % trajectoryCount]);
+        }
+    });
+
+    errors.assign(candidates.size(), 0.0);
+    for (size_t c = 0; c < candidates.size(); ++c) {
+        double sum = 0.0;
+        for (size_t t = 0; t < trajectoryCount; ++t) {
+            sum += sums[c * trajectoryCount + t];
+        }
+        errors[c] = sampleCount > 0 ? sum / sampleCount : 0.0;
+    }
+    evaluationCount += (int)candidates.size();
+}
+
+double Calibrator::error(const Table& table, const PhysicsParams& params) {
+    std::vector<PhysicsParams> candidates(1, params);
+    std::vector<double> result;
+    errors(table, candidates, result);
+    return result[0];
+}
+
+// Nelder-Mead works on a plain vector; these map it to and from the parameters,
+// clamped to values a real table can have
+static const int FIT_DIMENSIONS = 2;
+
+static PhysicsParams toParams(const PhysicsParams& base, const float* point) {
+    PhysicsParams params = base;
+    params.friction = clamp(point[0], PhysicsParams::MIN_FRICTION, PhysicsParams::MAX_FRICTION);
+    params.collisionDamping = clamp(point[1], PhysicsParams::MIN_COLLISION_DAMPING, PhysicsParams::MAX_COLLISION_DAMPING);
+    return params;
+}
+
+PhysicsParams Calibrator::searchSimplex(const Table& table, const PhysicsParams& start,
+    int maxIterations, float tolerance, double& bestValue) {
+    const int n = FIT_DIMENSIONS;
+    const int vertices = n + 1;
+    const float initialStep[FIT_DIMENSIONS] = { 0.01f, 0.1f };
+
+    // Initial simplex: the starting parameters and one step along each axis
+    float simplex[FIT_DIMENSIONS + 1][FIT_DIMENSIONS];
+    simplex[0][0] = start.friction;
+    simplex[0][1] = start.collisionDamping;
+    for (int v = 1; v < vertices; ++v) {
+        for (int d = 0; d < n; ++d) simplex[v][d] = simplex[0][d];
+        simplex[v][v - 1] += simplex[v][v - 1] + initialStep[v - 1] <= 1.0f ? initialStep[v - 1] : -initialStep[v - 1];
+    }
+
+    std::vector<PhysicsParams> candidates;
+    std::vector<double> candidateErrors;
+    double value[FIT_DIMENSIONS + 1];
+
+    // The whole simplex is one batch
+    for (int v = 0; v < vertices; ++v) candidates.push_back(toParams(table.physics, simplex[v]));
+    errors(table, candidates, candidateErrors);
+    for (int v = 0; v < vertices; ++v) value[v] = candidateErrors[v];
+
+    for (int iteration = 0; iteration < maxIterations; ++iteration) {
+        int order[FIT_DIMENSIONS + 1];
+        for (int v = 0; v < vertices; ++v) order[v] = v;
+        std::sort(order, order + vertices, [&](int a, int b) { return value[a] < value[b]; });
+        int best = order[0];
+        int worst = order[n];
+        int secondWorst = order[n - 1];
+
+        float size = 0.0f;
+        for (int v = 0; v < vertices; ++v) {
+            for (int d = 0; d < n; ++d) size = std::max(size, std::fabs(simplex[v][d] - simplex[best][d]));
+        }
+        if (size < tolerance) break;
+
+        float centroid[FIT_DIMENSIONS] = {};
+        for (int v = 0; v < vertices; ++v) {
+            if (v == worst) continue;
+            for (int d = 0; d < n; ++d) centroid[d] += simplex[v][d] / n;
+        }
+
+        // Every point this step might need - reflection, expansion and both contractions -
+        // goes out as one speculative batch, so even a single trajectory runs in parallel.
+        // The choice below is the same as evaluating them one by one.
+        float reflected[FIT_DIMENSIONS], expanded[FIT_DIMENSIONS];
+        float contractedOutside[FIT_DIMENSIONS], contractedInside[FIT_DIMENSIONS];
+        for (int d = 0; d < n; ++d) {
+            reflected[d] = centroid[d] + (centroid[d] - simplex[worst][d]);
+            expanded[d] = centroid[d] + 2.0f * (centroid[d] - simplex[worst][d]);
+            contractedOutside[d] = centroid[d] + 0.5f * (reflected[d] - centroid[d]);
+            contractedInside[d] = centroid[d] + 0.5f * (simplex[worst][d] - centroid[d]);
+        }
+        candidates.clear();
+        candidates.push_back(toParams(table.physics, reflected));
+        candidates.push_back(toParams(table.physics, expanded));
+        candidates.push_back(toParams(table.physics, contractedOutside));
+        candidates.push_back(toParams(table.physics, contractedInside));
+        errors(table, candidates, candidateErrors);
+        double reflectedValue = candidateErrors[0];
+
+        if (reflectedValue < value[best]) {
+            double expandedValue = candidateErrors[1];
+            const float* accepted = expandedValue < reflectedValue ? expanded : reflected;
+            for (int d = 0; d < n; ++d) simplex[worst][d] = accepted[d];
+            value[worst] = std::min(expandedValue, reflectedValue);
+            continue;
+        }
+        if (reflectedValue < value[secondWorst]) {
+            for (int d = 0; d < n; ++d) simplex[worst][d] = reflected[d];
+            value[worst] = reflectedValue;
+            continue;
+        }
+
+        // Contract towards the better of the worst point and its reflection
+        bool outside = reflectedValue < value[worst];
+        const float* contracted = outside ? contractedOutside : contractedInside;
+        double contractedValue = outside ? candidateErrors[2] : candidateErrors[3];
+        if (contractedValue < std::min(reflectedValue, value[worst])) {
+            for (int d = 0; d < n; ++d) simplex[worst][d] = contracted[d];
+            value[worst] = contractedValue;
+            continue;
+        }
+
+        // Shrink everything towards the best point, again as one batch
+        candidates.clear();
+        for (int v = 0; v < vertices; ++v) {
+            if (v == best) continue;
+            for (int d = 0; d < n; ++d) simplex[v][d] = simplex[best][d] + 0.5f * (simplex[v][d] - simplex[best][d]);
+            candidates.push_back(toParams(table.physics, simplex[v]));
+        }
+        errors(table, candidates, candidateErrors);
+        for (int v = 0, k = 0; v < vertices; ++v) {
+            if (v != best) value[v] = candidateErrors[k++];
+        }
+    }
+
+    int best = 0;
+    for (int v = 1; v < vertices; ++v) {
+        if (value[v] < value[best]) best = v;
+    }
+    bestValue = value[best];
+    return toParams(table.physics, simplex[best]);
+}
+
+PhysicsParams Calibrator::fit(const Table& table, int maxIterations, float tolerance) {
+    evaluationCount = 0;
+
+    // A collapsed simplex can sit on a ridge between two minima; a fresh one around
+    // the best point either confirms it or moves on
+    PhysicsParams best = table.physics;
+    fitError = std::numeric_limits<double>::max();
+    for (int restart = 0; restart <= FIT_RESTARTS; ++restart) {
+        double value;
+        PhysicsParams found = searchSimplex(table, best, maxIterations, tolerance, value);
+        if (value >= fitError) break;
+        best = found;
+        fitError = value;
+    }
+    return best;
+}
@@ -0,0 +1,88 @@
+#ifndef CALIBRATOR_H
+#define CALIBRATOR_H
+
+#include "Physics.h"
+#include "JobSystem.h"
+#include <string>
+#include <vector>
+
+// Snimljena putanja (npr. pracenje kugli sa videa): raspored pre udarca, udarac
+// i izmerene pozicije kugli u vremenu
+struct ReferenceTrajectory {
+    struct Sample {
+        float time;     // sekundi od udarca
+        int ball;
+        float x, y;
+    };
+
+    BallSystem balls;
+    Physics::Shot shot;
+    std::vector<Sample> samples;    // po vremenu
+};
+
+// Cita putanje iz tekstualnog fajla. Svaka putanja pocinje redom "trajectory",
+// a zatim (indeks kugle je redni broj reda "ball"):
+//   ball <x> <y> <radius>
+//   shot <ball> <angle> <speed>
+//   sample <time> <ball> <x> <y>
+// '#' pocinje komentar. Vraca false ako fajl ne postoji ili je neispravan.
+bool loadTrajectories(const std::string& path, std::vector<ReferenceTrajectory>& trajectories);
+
+// Podesava Table::physics prema snimljenim putanjama. Greska za skup parametara je
+// srednji kvadrat rastojanja izmedju simulirane i izmerene pozicije po uzorku;
+// simulacija je korak po korak (isti kod kao igra), a izmedju koraka se interpolira.
+// Minimum trazi Nelder-Mead (gradijent ne postoji: sudari cine gresku deo po deo
+// glatkom), sa parametrima ogranicenim na smislen opseg. Svaki korak unapred
+// racuna sve tacke koje mu mogu zatrebati (odraz, prosirenje, oba skupljanja), pa
+// se sve putanje svih tih kandidata simuliraju kao jedna serija preko JobSystem-a.
+class Calibrator {
+public:
+    // Koliko puta se simpleks ponovo gradi oko najbolje tacke
+    static const int FIT_RESTARTS = 2;
+
+    explicit Calibrator(JobSystem& jobs);
+
+    void setTrajectories(const std::vector<ReferenceTrajectory>& trajectories) { this->trajectories = trajectories; }
+    void setStepDt(float dt) { stepDt = dt; }
+
+    // Greska za sto table sa parametrima params (m^2)
+    double error(const Table& table, const PhysicsParams& params);
+
+    // Greske za vise kandidata odjednom; errors[k] pripada candidates[k]
+    void errors(const Table& table, const std::vector<PhysicsParams>& candidates, std::vector<double>& errors);
+
+    // Nelder-Mead od table.physics; staje kad se simpleks skupi ispod tolerance
+    // (po parametru) ili posle maxIterations koraka, pa krece ponovo oko najboljeg
+    PhysicsParams fit(const Table& table, int maxIterations = 200, float tolerance = 1e-5f);
+
+    // Greska najboljeg rezultata poslednjeg fit-a i broj izracunatih gresaka
+    double getFitError() const { return fitError; }
+    int getEvaluationCount() const { return evaluationCount; }
+
+private:
+    struct WorkerScratch {
+        BallSystem balls;
+        GridBroadphase broadphase;
+        Narrowphase narrowphase;
+        std::vector<float> lastX, lastY;   // poslednja pozicija na stolu (za upale kugle)
+    };
+
+    // Zbir kvadrata gresaka jedne putanje
+    double simulate(int worker, const Table& table, const ReferenceTrajectory& trajectory);
+
+    // Jedan prolaz Nelder-Mead-a od start; bestValue je greska vracenih parametara
+    PhysicsParams searchSimplex(const Table& table, const PhysicsParams& start,
+        int maxIterations, float tolerance, double& bestValue);
+
+    JobSystem* jobs;
+    std::vector<WorkerScratch> scratch;
+    std::vector<ReferenceTrajectory> trajectories;
+    std::vector<Table> candidateTables;
+    std::vector<double> sums;
+    float stepDt;
+
+    double fitError;
+    int evaluationCount;
+};
+
+#endif
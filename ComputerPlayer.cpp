@@ -0,0 +1,252 @@
+#include "ComputerPlayer.h"
+#include "Header/Util.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// Relative to the minimum power the shot needs; the first level is tried on every candidate first
+static const float POWER_FACTORS[ComputerPlayer::POWER_LEVELS] = { 1.6f, 1.2f, 2.4f, 3.5f };
+
+// Cuts thinner than this (about 81 degrees) are not attempted
+static const float MIN_CUT_COS = 0.15f;
+
+static const float STEP_DT = 1.0f / 240.0f;
+static const double CONTACT_TIME_LIMIT = 10.0;
+static const double REST_TIME_LIMIT = 60.0;
+static const float FOUL_SCORE = -10.0f;
+
+ComputerPlayer::ComputerPlayer(JobSystem& jobs)
+    : jobs(&jobs), table(nullptr), cueBall(0), search(0),
+    timeBudget(0.5), maxEvaluations(0), minPower(0.6f), maxPower(7.2f), evaluatedCount(0) {
+    scratch.resize(jobs.getWorkerCount());
+}
+
+// True if a ball of the given radius moving from (x1, y1) to (x2, y2) would touch any
+// active ball other than skipA and skipB
+static bool pathBlocked(const BallSystem& balls, float x1, float y1, float x2, float y2,
+    float radius, int skipA, int skipB) {
+    float dx = x2 - x1;
+    float dy = y2 - y1;
+    float len2 = dx * dx + dy * dy;
+    float minX = std::min(x1, x2), maxX = std::max(x1, x2);
+    float minY = std::min(y1, y2), maxY = std::max(y1, y2);
+
+    for (size_t i = 0; i < balls.size(); ++i) {
+        if (!balls.active[i] || (int)i == skipA || (int)i == skipB) continue;
+
+        float bx = toFloat(balls.x[i]);
+        float by = toFloat(balls.y[i]);
+        float reach = radius + toFloat(balls.radius[i]);
+        if (bx < minX - reach || bx > maxX + reach || by < minY - reach || by > maxY + reach) continue;
+
+        float t = len2 > 0.0f ? clamp(dot(bx - x1, by - y1, dx, dy) / len2, 0.0f, 1.0f) : 0.0f;
+        float cx = x1 + dx * t - bx;
+        float cy = y1 + dy * t - by;
+        if (cx * cx + cy * cy < reach * reach) return true;
+    }
+    return false;
+}
+
+// Speed a ball needs to roll distance under constant friction deceleration
+static float speedToTravel(float distance, float deceleration) {
+    return std::sqrt(2.0f * deceleration * distance);
+}
+
+void ComputerPlayer::findAims(const BallSystem& balls, const Table& table, int cueBall, std::vector<CandidateShot>& aims) {
+    aims.clear();
+
+    float cx = toFloat(balls.x[cueBall]);
+    float cy = toFloat(balls.y[cueBall]);
+    float cueRadius = toFloat(balls.radius[cueBall]);
+    float deceleration = table.physics.frictionDeceleration();
+
+    for (size_t target = 0; target < balls.size(); ++target) {
+        if (!balls.active[target] || (int)target == cueBall) continue;
+        float tx = toFloat(balls.x[target]);
+        float ty = toFloat(balls.y[target]);
+        float targetRadius = toFloat(balls.radius[target]);
+
+        for (size_t pocket = 0; pocket < table.pockets.size(); ++pocket) {
+            const Pocket& p = table.pockets[pocket];
+            float ux = p.x - tx;
+            float uy = p.y - ty;
+            float pocketDist = length(ux, uy);
+            if (pocketDist < 0.0001f) continue;
+            ux /= pocketDist;
+            uy /= pocketDist;
+
+            // Ghost ball: where the cue's centre must be at contact to send the target along u
+            float gx = tx - ux * (cueRadius + targetRadius);
+            float gy = ty - uy * (cueRadius + targetRadius);
+            float ax = gx - cx;
+            float ay = gy - cy;
+            float cueDist = length(ax, ay);
+            if (cueDist < 0.0001f) continue;
+
+            float cutCos = dot(ax, ay, ux, uy) / cueDist;
+            if (cutCos < MIN_CUT_COS) continue;
+
+            if (pathBlocked(balls, cx, cy, gx, gy, cueRadius, cueBall, (int)target)) continue;
+            if (pathBlocked(balls, tx, ty, p.x, p.y, targetRadius, cueBall, (int)target)) continue;
+
+            // The target leaves with the cue's normal speed component, less damping
+            float targetSpeed = speedToTravel(pocketDist, deceleration);
+            float contactSpeed = targetSpeed / (cutCos * table.physics.collisionDamping);
+            float baseSpeed = std::sqrt(contactSpeed * contactSpeed + speedToTravel(cueDist, deceleration) * speedToTravel(cueDist, deceleration));
+
+            CandidateShot aim;
+            aim.shot = Physics::Shot{ cueBall, std::atan2(ay, ax), baseSpeed };
+            aim.target = (int)target;
+            aim.pocket = (int)pocket;
+            aim.cutCos = cutCos;
+            // Straight, short shots are the most likely to go in
+            aim.difficulty = (1.0f - cutCos) * 2.0f + distance(cx, cy, p.x, p.y);
+            aim.score = 0.0f;
+            aim.evaluated = false;
+            aim.foul = false;
+            aims.push_back(aim);
+        }
+    }
+
+    // Ties keep generation order; std::sort, unlike stable_sort, needs no temporary buffer
+    std::sort(aims.begin(), aims.end(), [](const CandidateShot& a, const CandidateShot& b) {
+        if (a.difficulty != b.difficulty) return a.difficulty < b.difficulty;
+        return a.target != b.target ? a.target < b.target : a.pocket < b.pocket;
+    });
+}
+
+void ComputerPlayer::generateCandidates(const BallSystem& balls, const Table& table, int cueBall) {
+    findAims(balls, table, cueBall, aims);
+
+    candidates.clear();
+    for (int level = 0; level < POWER_LEVELS; ++level) {
+        for (const CandidateShot& aim : aims) {
+            CandidateShot candidate = aim;
+            candidate.shot.speed = clamp(aim.shot.speed * POWER_FACTORS[level], minPower, maxPower);
+            candidates.push_back(candidate);
+        }
+    }
+}
+
+// The first ball other than the cue that started moving; balls start at rest,
+// so this is the ball the cue touched. Nearest to the cue if several moved.
+static int firstMoved(const BallSystem& balls, int cueBall) {
+    int found = -1;
+    Real nearest = 0.0f;
+    for (size_t i = 0; i < balls.size(); ++i) {
+        if ((int)i == cueBall || !balls.active[i]) continue;
+        if (balls.vx[i] == 0.0f && balls.vy[i] == 0.0f) continue;
+
+        Real dx = balls.x[i] - balls.x[cueBall];
+        Real dy = balls.y[i] - balls.y[cueBall];
+        Real dist2 = dx * dx + dy * dy;
+        if (found < 0 || dist2 < nearest) {
+            found = (int)i;
+            nearest = dist2;
+        }
+    }
+    return found;
+}
+
+void ComputerPlayer::evaluate(int worker, CandidateShot& candidate) {
+    WorkerScratch& local = scratch[worker];
+    if (local.search != search) {
+        if (local.snapshot.getCapacity() < initial.size()) local.snapshot = Snapshot(initial.size());
+        local.balls = initial;
+        local.snapshot.capture(local.balls);
+        local.search = search;
+    }
+    else {
+        local.snapshot.restore(local.balls);
+    }
+
+    BallSystem& balls = local.balls;
+    Physics::applyShot(balls, candidate.shot);
+
+    // Step only until the cue's first contact; a wrong first ball ends the evaluation
+    int contact = -1;
+    int maxSteps = (int)(CONTACT_TIME_LIMIT / STEP_DT);
+    for (int step = 0; step < maxSteps; ++step) {
+        Physics::updatePhysics(balls, *table, STEP_DT, local.broadphase, local.narrowphase);
+        contact = firstMoved(balls, cueBall);
+        if (contact >= 0 || !balls.active[cueBall] || balls.asleep[cueBall]) break;
+    }
+
+    candidate.evaluated = true;
+    if (contact != candidate.target) {
+        candidate.foul = true;
+        candidate.score = FOUL_SCORE;
+        return;
+    }
+
+    local.events.run(balls, *table, REST_TIME_LIMIT);
+
+    int pocketed = 0;
+    for (size_t i = 0; i < balls.size(); ++i) {
+        if ((int)i != cueBall && initial.active[i] && !balls.active[i]) ++pocketed;
+    }
+    bool scratched = !balls.active[cueBall];
+
+    // Straighter shots win ties, since they are less sensitive to aim error
+    candidate.score = pocketed - (scratched ? 2.0f : 0.0f) + 0.1f * candidate.cutCos;
+}
+
+Physics::Shot ComputerPlayer::fallbackShot(const BallSystem& balls, int cueBall) const {
+    Physics::Shot shot{ cueBall, 0.0f, (minPower + maxPower) * 0.5f };
+    int nearest = -1;
+    Real nearestDist = 0.0f;
+    for (size_t i = 0; i < balls.size(); ++i) {
+        if ((int)i == cueBall || !balls.active[i]) continue;
+        Real dx = balls.x[i] - balls.x[cueBall];
+        Real dy = balls.y[i] - balls.y[cueBall];
+        Real dist2 = dx * dx + dy * dy;
+        if (nearest < 0 || dist2 < nearestDist) {
+            nearest = (int)i;
+            nearestDist = dist2;
+        }
+    }
+    if (nearest >= 0) {
+        shot.angle = std::atan2(toFloat(balls.y[nearest] - balls.y[cueBall]), toFloat(balls.x[nearest] - balls.x[cueBall]));
+    }
+    return shot;
+}
+
+Physics::Shot ComputerPlayer::chooseShot(const BallSystem& balls, const Table& table, int cueBall) {
+    initial = balls;
+    this->table = &table;
+    this->cueBall = cueBall;
+    ++search;
+
+    generateCandidates(balls, table, cueBall);
+
+    // An evaluation limit replaces the clock, so a slow or busy machine gets the same shot
+    bool timed = maxEvaluations <= 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(timeBudget);
+    size_t limit = candidates.size();
+    if (!timed && (size_t)maxEvaluations < limit) limit = (size_t)maxEvaluations;
+
+    // One job per worker pulling candidates from a shared cursor, so they are tried
+    // strictly easiest first whatever order the queues run in
+    std::atomic<size_t> next(0);
+    JobGroup group;
+    for (int worker = 0; worker < jobs->getWorkerCount(); ++worker) {
+        jobs->submit(group, [this, &next, limit, timed, deadline](int worker) {
+            for (;;) {
+                size_t k = next.fetch_add(1, std::memory_order_relaxed);
+                if (k >= limit || (timed && std::chrono::steady_clock::now() >= deadline)) return;
+                evaluate(worker, candidates[k]);
+            }
+        });
+    }
+    jobs->wait(group);
+
+    const CandidateShot* best = nullptr;
+    evaluatedCount = 0;
+    for (const CandidateShot& candidate : candidates) {
+        if (!candidate.evaluated) continue;
+        ++evaluatedCount;
+        if (candidate.foul) continue;
+        if (!best || candidate.score > best->score) best = &candidate;
+    }
+    return best ? best->shot : fallbackShot(balls, cueBall);
+}
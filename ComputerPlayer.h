@@ -0,0 +1,88 @@
+#ifndef COMPUTER_PLAYER_H
+#define COMPUTER_PLAYER_H
+
+#include "Physics.h"
+#include "JobSystem.h"
+#include "Snapshot.h"
+#include <atomic>
+#include <vector>
+
+// Kandidat za udarac: bela ide na "duh" kugle (mesto gde bela dodiruje metu
+// tako da meta krene ka dzepu) sa jednom od nekoliko jacina
+struct CandidateShot {
+    Physics::Shot shot;
+    int target;         // kugla u koju se cilja
+    int pocket;         // indeks u Table::pockets
+    float cutCos;       // kosinus ugla reza (1 = pravo)
+    float difficulty;   // geometrijska procena tezine (manje je lakse)
+    float score;        // ishod simulacije (vece je bolje)
+    bool evaluated;     // simuliran pre isteka vremena
+    bool foul;          // bela je prvo udarila drugu kuglu ili nijednu
+};
+
+// Racunarski protivnik. Za svaki par (kugla, dzep) racuna tacku ciljanja preko
+// duha kugle, odbacuje udarce kojima put bele ili mete zaklanja druga kugla
+// (zrak debljine zbira radijusa), pa preostale simulira paralelno preko JobSystem-a.
+// Simulacija se prekida cim bela prvo dotakne pogresnu kuglu.
+//
+// Pretraga je "anytime": kandidati idu od najlaksih (mali rez, kratak put) ka
+// tezim, prvo sa osnovnom jacinom pa sa ostalim, i kad istekne vreme vraca se
+// najbolji do tada. setMaxEvaluations zamenjuje vremensko ogranicenje brojem
+// ocenjenih kandidata, pa ishod ne zavisi od brzine ni opterecenja masine.
+class ComputerPlayer {
+public:
+    // Jacine u odnosu na procenjenu minimalnu, redom kojim se isprobavaju
+    static const int POWER_LEVELS = 4;
+
+    explicit ComputerPlayer(JobSystem& jobs);
+
+    void setTimeBudget(double seconds) { timeBudget = seconds; }
+    void setMaxEvaluations(int count) { maxEvaluations = count; }  // 0 = ogranicava samo vreme
+    void setPowerRange(float minPower, float maxPower) { this->minPower = minPower; this->maxPower = maxPower; }
+
+    // Bira udarac za kuglu cueBall; sve kugle treba da miruju. Ako nema slobodnog
+    // udarca, gadja najblizu kuglu direktno.
+    Physics::Shot chooseShot(const BallSystem& balls, const Table& table, int cueBall);
+
+    // Slobodni udarci preko duha kugle sa minimalnom jacinom, od najlakseg, bez simulacije.
+    // aims se prazni i puni (kapacitet ostaje, pa ponovljeni pozivi ne zauzimaju memoriju).
+    static void findAims(const BallSystem& balls, const Table& table, int cueBall, std::vector<CandidateShot>& aims);
+
+    // Kandidati iz poslednje pretrage, redom kojim su isprobavani
+    const std::vector<CandidateShot>& getCandidates() const { return candidates; }
+    int getEvaluatedCount() const { return evaluatedCount; }
+
+private:
+    struct WorkerScratch {
+        BallSystem balls;
+        Snapshot snapshot;
+        EventSimulator events;
+        GridBroadphase broadphase;
+        Narrowphase narrowphase;
+        unsigned search;
+
+        WorkerScratch() : snapshot(0), search(0) {}
+    };
+
+    void generateCandidates(const BallSystem& balls, const Table& table, int cueBall);
+    void evaluate(int worker, CandidateShot& candidate);
+    Physics::Shot fallbackShot(const BallSystem& balls, int cueBall) const;
+
+    JobSystem* jobs;
+    std::vector<WorkerScratch> scratch;
+    std::vector<CandidateShot> candidates;
+    std::vector<CandidateShot> aims;
+
+    // Stanje tekuce pretrage (samo za citanje dok poslovi rade)
+    BallSystem initial;
+    const Table* table;
+    int cueBall;
+    unsigned search;
+
+    double timeBudget;
+    int maxEvaluations;
+    float minPower, maxPower;
+    int evaluatedCount;
+};
+
+#endif
@@ -0,0 +1,514 @@
+#include "EventSimulator.h"
+#include "Physics.h"
+#include "BoundaryField.h"
+#include "SegmentBVH.h"
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+static const double NEVER = std::numeric_limits<double>::infinity();
+
+// ---- Polynomial helpers: f(t) = c[0] + c[1] t + ... + c[degree] t^degree ----
+
+static double evalPoly(const double* c, int degree, double t) {
+    double value = c[degree];
+    for (int k = degree - 1; k >= 0; --k) {
+        value = value * t + c[k];
+    }
+    return value;
+}
+
+static void derivePoly(const double* c, int degree, double* d) {
+    for (int k = 1; k <= degree; ++k) {
+        d[k - 1] = c[k] * k;
+    }
+}
+
+// Shrinks [a, b] around the sign change of a monotonic piece and returns the
+// end that has the same sign as f(b), so the caller lands on the far side
+static double bisectRoot(const double* c, int degree, double a, double b) {
+    bool negativeAtA = evalPoly(c, degree, a) < 0.0;
+    for (int it = 0; it < 200 && b - a > 1e-14 * (1.0 + std::fabs(b)); ++it) {
+        double m = 0.5 * (a + b);
+        if ((evalPoly(c, degree, m) < 0.0) == negativeAtA) a = m;
+        else b = m;
+    }
+    return b;
+}
+
+// All roots inside (lo, hi) in ascending order. Roots of the derivative split
+// the interval into monotonic pieces, each of which holds at most one root.
+static int rootsInInterval(const double* c, int degree, double lo, double hi, double* roots) {
+    while (degree > 0 && c[degree] == 0.0) --degree;
+    if (degree == 0) return 0;
+
+    if (degree == 1) {
+        double t = -c[0] / c[1];
+        if (t > lo && t < hi) {
+            roots[0] = t;
+            return 1;
+        }
+        return 0;
+    }
+
+    double d[4] = {};
+    double critical[4];
+    derivePoly(c, degree, d);
+    int criticalCount = rootsInInterval(d, degree - 1, lo, hi, critical);
+
+    int count = 0;
+    double a = lo;
+    double fa = evalPoly(c, degree, a);
+    for (int k = 0; k <= criticalCount; ++k) {
+        double b = k < criticalCount ? critical[k] : hi;
+        double fb = evalPoly(c, degree, b);
+        if ((fa < 0.0) != (fb < 0.0)) {
+            roots[count++] = bisectRoot(c, degree, a, b);
+        }
+        a = b;
+        fa = fb;
+    }
+    return count;
+}
+
+// First time in [0, horizon] where f goes from positive to non-positive,
+// or -1. Touching (f <= 0) while still decreasing counts as an entry at 0.
+static double firstEntry(const double* c, int degree, double horizon) {
+    if (horizon <= 0.0) return -1.0;
+
+    double d[4];
+    derivePoly(c, degree, d);
+
+    double f0 = c[0];
+    if (f0 <= 0.0 && c[1] < 0.0) return 0.0;
+
+    double critical[4];
+    int criticalCount = rootsInInterval(d, degree - 1, 0.0, horizon, critical);
+
+    double a = 0.0;
+    double fa = f0;
+    for (int k = 0; k <= criticalCount; ++k) {
+        double b = k < criticalCount ? critical[k] : horizon;
+        double fb = evalPoly(c, degree, b);
+        if (fa > 0.0 && fb <= 0.0) {
+            return bisectRoot(c, degree, a, b);
+        }
+        a = b;
+        fa = fb;
+    }
+    return -1.0;
+}
+
+// |d0 + dv t + da t^2 / 2|^2 - reach^2 as a quartic in t
+static void distanceQuartic(double dx, double dy, double dvx, double dvy, double dax, double day,
+    double reach, double* c) {
+    c[0] = dx * dx + dy * dy - reach * reach;
+    c[1] = 2.0 * (dx * dvx + dy * dvy);
+    c[2] = dvx * dvx + dvy * dvy + dx * dax + dy * day;
+    c[3] = dvx * dax + dvy * day;
+    c[4] = 0.25 * (dax * dax + day * day);
+}
+
+// ---- EventSimulator ----
+
+bool EventSimulator::Later::operator()(const Event& lhs, const Event& rhs) const {
+    // Min-heap on time; ties broken by type and balls so runs are reproducible
+    if (lhs.time != rhs.time) return lhs.time > rhs.time;
+    if (lhs.type != rhs.type) return lhs.type > rhs.type;
+    if (lhs.a != rhs.a) return lhs.a > rhs.a;
+    return lhs.b > rhs.b;
+}
+
+EventSimulator::EventSimulator()
+    : table(nullptr), now(0.0), pullStep(0.001), deceleration(0.0), pullAcceleration(0.0),
+    eventCount(0), maxEvents(1000000), settled(true) {}
+
+void EventSimulator::push(double time, EventType type, int a, int b) {
+    Event event;
+    event.time = time;
+    event.type = type;
+    event.a = a;
+    event.b = b;
+    event.versionA = version[a];
+    event.versionB = type == BallBall ? version[b] : -1;
+    queue.push(event);
+}
+
+void EventSimulator::advance(int i, double time) {
+    double dt = std::min(time, tEnd[i]) - t0[i];
+    if (dt > 0.0) {
+        px[i] += vx[i] * dt + 0.5 * ax[i] * dt * dt;
+        py[i] += vy[i] * dt + 0.5 * ay[i] * dt * dt;
+        vx[i] += ax[i] * dt;
+        vy[i] += ay[i] * dt;
+    }
+    t0[i] = time;
+}
+
+int EventSimulator::pullPocketFor(int i) const {
+    for (size_t k = 0; k < table->pockets.size(); ++k) {
+        const Pocket& pocket = table->pockets[k];
+        double dx = px[i] - pocket.x;
+        double dy = py[i] - pocket.y;
+        double reach = pocket.radius + radius[i];
+        if (dx * dx + dy * dy < reach * reach) return (int)k;
+    }
+    return -1;
+}
+
+void EventSimulator::setMotion(int i) {
+    setMotion(i, pullPocketFor(i));
+}
+
+void EventSimulator::setMotion(int i, int pocket) {
+    double speed = std::sqrt(vx[i] * vx[i] + vy[i] * vy[i]);
+    pullPocket[i] = pocket;
+
+    if (speed > 0.0) {
+        ax[i] = -deceleration * vx[i] / speed;
+        ay[i] = -deceleration * vy[i] / speed;
+        tStop[i] = now + speed / deceleration;
+    }
+    else {
+        vx[i] = vy[i] = 0.0;
+        ax[i] = ay[i] = 0.0;
+        tStop[i] = NEVER;
+    }
+    tEnd[i] = tStop[i];
+
+    // A resting ball stays put in the pull zone if friction outweighs the pull
+    if (pullPocket[i] >= 0 && (speed > 0.0 || pullAcceleration > deceleration)) {
+        tEnd[i] = std::min(tEnd[i], now + pullStep);
+    }
+
+    t0[i] = now;
+    version[i]++;
+}
+
+void EventSimulator::predictPair(int i, int j) {
+    if (!active[j] || i == j) return;
+
+    bool movingI = tEnd[i] != NEVER;
+    bool movingJ = tEnd[j] != NEVER;
+    if (!movingI && !movingJ) return;
+
+    double horizon = std::min(tEnd[i], tEnd[j]) - now;
+    if (horizon <= 0.0) return;
+
+    // Both balls are evaluated at the current time
+    double dtI = now - t0[i];
+    double dtJ = now - t0[j];
+    double xi = px[i] + vx[i] * dtI + 0.5 * ax[i] * dtI * dtI;
+    double yi = py[i] + vy[i] * dtI + 0.5 * ay[i] * dtI * dtI;
+    double xj = px[j] + vx[j] * dtJ + 0.5 * ax[j] * dtJ * dtJ;
+    double yj = py[j] + vy[j] * dtJ + 0.5 * ay[j] * dtJ * dtJ;
+    double vxi = vx[i] + ax[i] * dtI, vyi = vy[i] + ay[i] * dtI;
+    double vxj = vx[j] + ax[j] * dtJ, vyj = vy[j] + ay[j] * dtJ;
+
+    double c[5];
+    distanceQuartic(xj - xi, yj - yi, vxj - vxi, vyj - vyi, ax[j] - ax[i], ay[j] - ay[i],
+        radius[i] + radius[j], c);
+
+    double t = firstEntry(c, 4, horizon);
+    if (t >= 0.0) {
+        push(now + t, BallBall, std::min(i, j), std::max(i, j));
+    }
+}
+
+void EventSimulator::predict(int i) {
+    if (!active[i]) return;
+
+    for (size_t j = 0; j < active.size(); ++j) {
+        predictPair(i, (int)j);
+    }
+
+    if (tEnd[i] == NEVER) return;
+    push(tEnd[i], Horizon, i, -1);
+
+    double horizon = tEnd[i] - now;
+    double c[5];
+
+    // Cushions: inside a pull zone the ball moves in pull steps and meets the pocket
+    // jaws through the boundary field
+    if (pullPocket[i] < 0) predictCushions(i, horizon);
+
+    for (size_t k = 0; k < table->pockets.size(); ++k) {
+        const Pocket& pocket = table->pockets[k];
+        double dx = px[i] - pocket.x;
+        double dy = py[i] - pocket.y;
+
+        if (pullPocket[i] == (int)k) {
+            distanceQuartic(dx, dy, vx[i], vy[i], ax[i], ay[i], pocket.radius * Physics::POCKET_CAPTURE, c);
+            double t = firstEntry(c, 4, horizon);
+            if (t >= 0.0) push(now + t, Capture, i, (int)k);
+        }
+        else if (pullPocket[i] < 0) {
+            distanceQuartic(dx, dy, vx[i], vy[i], ax[i], ay[i], pocket.radius + radius[i], c);
+            double t = firstEntry(c, 4, horizon);
+            if (t >= 0.0) push(now + t, PocketZone, i, (int)k);
+        }
+    }
+}
+
+void EventSimulator::predictCushions(int i, double horizon) {
+    // The path is straight, from where the ball is now to where it is at the horizon;
+    // the margin covers rounding to float
+    double endX = px[i] + vx[i] * horizon + 0.5 * ax[i] * horizon * horizon;
+    double endY = py[i] + vy[i] * horizon + 0.5 * ay[i] * horizon * horizon;
+    double r = radius[i];
+    const SegmentBVH& tree = table->getCushionTree();
+    const std::vector<CushionSegment>& segments = tree.getSegments();
+
+    tree.querySegment((float)px[i], (float)py[i], (float)endX, (float)endY, (float)r * 1.01f, [&](int k) {
+        const CushionSegment& s = segments[k];
+
+        // Face: the gap to the line is quadratic in time; the contact must land on the segment
+        double gap[3] = {
+            -((px[i] - s.x0) * s.nx + (py[i] - s.y0) * s.ny) - r,
+            -(vx[i] * s.nx + vy[i] * s.ny),
+            -0.5 * (ax[i] * s.nx + ay[i] * s.ny)
+        };
+        if (gap[0] >= 0.0) {
+            double t = firstEntry(gap, 2, horizon);
+            if (t >= 0.0) {
+                double cx = px[i] + vx[i] * t + 0.5 * ax[i] * t * t;
+                double cy = py[i] + vy[i] * t + 0.5 * ay[i] * t * t;
+                double ux = (double)s.x1 - s.x0, uy = (double)s.y1 - s.y0;
+                double along = (cx - s.x0) * ux + (cy - s.y0) * uy;
+                if (along >= 0.0 && along <= ux * ux + uy * uy) push(now + t, Cushion, i, k);
+            }
+        }
+
+        // Vertex (each starts exactly one segment of its loop): quartic like a ball pair
+        double c[5];
+        distanceQuartic(s.x0 - px[i], s.y0 - py[i], -vx[i], -vy[i], -ax[i], -ay[i], r, c);
+        double t = firstEntry(c, 4, horizon);
+        if (t >= 0.0) push(now + t, Cushion, i, k);
+    });
+}
+
+void EventSimulator::resolveBoundary(int i) {
+    // Same contact as Physics::handleWallCollision
+    BoundarySample edge = table->getBoundary().sample((float)px[i], (float)py[i]);
+    double nx = toFloat(edge.nx), ny = toFloat(edge.ny);
+    double penetration = radius[i] + toFloat(edge.distance);
+    if (penetration <= 0.0) return;
+
+    px[i] -= penetration * nx;
+    py[i] -= penetration * ny;
+    double vn = vx[i] * nx + vy[i] * ny;
+    if (vn > 0.0) {
+        double bounce = vn * (1.0 + table->physics.collisionDamping);
+        vx[i] -= bounce * nx;
+        vy[i] -= bounce * ny;
+    }
+}
+
+void EventSimulator::resolveBallBall(int i, int j) {
+    advance(i, now);
+    advance(j, now);
+
+    double dx = px[j] - px[i];
+    double dy = py[j] - py[i];
+    double dist = std::sqrt(dx * dx + dy * dy);
+    if (dist > 0.0) {
+        double nx = dx / dist;
+        double ny = dy / dist;
+        double dvn = (vx[j] - vx[i]) * nx + (vy[j] - vy[i]) * ny;
+
+        // Same impulse as handleBallCollision, applied at the moment of contact
+        if (dvn < 0.0) {
+            double impulse = dvn * table->physics.collisionDamping;
+            vx[i] += impulse * nx;
+            vy[i] += impulse * ny;
+            vx[j] -= impulse * nx;
+            vy[j] -= impulse * ny;
+        }
+    }
+
+    setMotion(i);
+    setMotion(j);
+    predict(i);
+    predict(j);
+}
+
+void EventSimulator::resolveCushion(int i, int segment) {
+    advance(i, now);
+
+    // The contact normal points to the nearest point of the segment: the face normal,
+    // or the direction to the vertex the ball touched
+    const CushionSegment& s = table->getCushionTree().getSegments()[segment];
+    double ux = (double)s.x1 - s.x0, uy = (double)s.y1 - s.y0;
+    double t = ((px[i] - s.x0) * ux + (py[i] - s.y0) * uy) / (ux * ux + uy * uy);
+    t = std::min(std::max(t, 0.0), 1.0);
+    double qx = s.x0 + ux * t, qy = s.y0 + uy * t;
+    double dist = std::sqrt((qx - px[i]) * (qx - px[i]) + (qy - py[i]) * (qy - py[i]));
+    double nx = dist > 0.0 ? (qx - px[i]) / dist : s.nx;
+    double ny = dist > 0.0 ? (qy - py[i]) / dist : s.ny;
+
+    // Exactly one radius off, so the next prediction does not see the same contact again
+    px[i] = qx - nx * radius[i];
+    py[i] = qy - ny * radius[i];
+
+    // Same bounce as handleWallCollision
+    double vn = vx[i] * nx + vy[i] * ny;
+    if (vn > 0.0) {
+        double bounce = vn * (1.0 + table->physics.collisionDamping);
+        vx[i] -= bounce * nx;
+        vy[i] -= bounce * ny;
+    }
+
+    setMotion(i);
+    predict(i);
+}
+
+void EventSimulator::resolvePocketZone(int i, int pocket) {
+    advance(i, now);
+
+    // The entry time lands on the zone rim, and rounding can leave the ball a hair
+    // outside it; recomputing the zone would then predict the same entry again forever
+    int inside = pullPocketFor(i);
+    setMotion(i, inside >= 0 ? inside : pocket);
+    predict(i);
+}
+
+void EventSimulator::resolveCapture(int i) {
+    advance(i, now);
+
+    active[i] = false;
+    px[i] = -10.0;
+    py[i] = -10.0;
+    vx[i] = vy[i] = 0.0;
+    ax[i] = ay[i] = 0.0;
+    tEnd[i] = tStop[i] = NEVER;
+    version[i]++;
+}
+
+void EventSimulator::resolveHorizon(int i) {
+    double start = t0[i];
+    advance(i, now);
+
+    // Reached the stop time - drop the rounding leftovers
+    if (now >= tStop[i]) {
+        vx[i] = vy[i] = 0.0;
+    }
+
+    // Pull impulse for the elapsed pull step, like handlePocketCollision does each frame
+    int k = pullPocket[i];
+    if (k >= 0) {
+        const Pocket& pocket = table->pockets[k];
+        double dx = pocket.x - px[i];
+        double dy = pocket.y - py[i];
+        double dist = std::sqrt(dx * dx + dy * dy);
+        if (dist > 0.0 && dist < pocket.radius + radius[i]) {
+            double impulse = pullAcceleration * (now - start);
+            vx[i] += dx / dist * impulse;
+            vy[i] += dy / dist * impulse;
+        }
+        resolveBoundary(i);
+    }
+
+    setMotion(i);
+    predict(i);
+}
+
+void EventSimulator::setup(BallSystem& balls, const Table& table) {
+    this->table = &table;
+    now = 0.0;
+    eventCount = 0;
+    settled = true;
+    pocketed.clear();
+    deceleration = table.physics.frictionDeceleration();
+    pullAcceleration = Physics::POCKET_PULL * Physics::REFERENCE_STEP_RATE;
+    queue = std::priority_queue<Event, std::vector<Event>, Later>();
+
+    size_t n = balls.size();
+    t0.assign(n, 0.0);
+    px.resize(n);
+    py.resize(n);
+    vx.resize(n);
+    vy.resize(n);
+    ax.assign(n, 0.0);
+    ay.assign(n, 0.0);
+    tEnd.assign(n, NEVER);
+    tStop.assign(n, NEVER);
+    radius.resize(n);
+    version.assign(n, 0);
+    pullPocket.assign(n, -1);
+    active.resize(n);
+
+    for (size_t i = 0; i < n; ++i) {
+        px[i] = toFloat(balls.x[i]);
+        py[i] = toFloat(balls.y[i]);
+        vx[i] = toFloat(balls.vx[i]);
+        vy[i] = toFloat(balls.vy[i]);
+        radius[i] = toFloat(balls.radius[i]);
+        active[i] = balls.active[i];
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        if (active[i]) setMotion((int)i);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        predict((int)i);
+    }
+}
+
+void EventSimulator::finish(BallSystem& balls, double time) {
+    for (size_t i = 0; i < balls.size(); ++i) {
+        if (active[i]) advance((int)i, time);
+        balls.x[i] = (float)px[i];
+        balls.y[i] = (float)py[i];
+        balls.vx[i] = (float)vx[i];
+        balls.vy[i] = (float)vy[i];
+        balls.active[i] = active[i];
+    }
+    balls.wakeAll();
+}
+
+double EventSimulator::run(BallSystem& balls, const Table& table, double maxTime) {
+    setup(balls, table);
+
+    double endTime = now;
+    while (!queue.empty()) {
+        Event event = queue.top();
+        queue.pop();
+
+        // Lazy invalidation: the event was predicted from an outdated motion. Checked
+        // before the cut-off, so a stale event past maxTime cannot mark the run unsettled
+        if (!active[event.a] || version[event.a] != event.versionA) continue;
+        if (event.type == BallBall && (!active[event.b] || version[event.b] != event.versionB)) continue;
+
+        if (event.time > maxTime || eventCount >= maxEvents) {
+            endTime = std::min(event.time, maxTime);
+            settled = false;
+            break;
+        }
+
+        now = event.time;
+        endTime = now;
+        eventCount++;
+
+        switch (event.type) {
+        case BallBall:
+            resolveBallBall(event.a, event.b);
+            break;
+        case Cushion:
+            resolveCushion(event.a, event.b);
+            break;
+        case PocketZone:
+            resolvePocketZone(event.a, event.b);
+            break;
+        case Capture:
+            resolveCapture(event.a);
+            pocketed.push_back({ event.a, event.b, now });
+            break;
+        case Horizon:
+            resolveHorizon(event.a);
+            break;
+        }
+    }
+
+    finish(balls, endTime);
+    return endTime;
+}
@@ -0,0 +1,111 @@
+#ifndef EVENT_SIMULATOR_H
+#define EVENT_SIMULATOR_H
+
+#include "BallSystem.h"
+#include "Table.h"
+#include <vector>
+#include <queue>
+
+// Simulacija vodjena dogadjajima, alternativa za Physics::updatePhysics.
+// Izmedju dogadjaja kugla se krece sa konstantnim usporenjem od trenja, pa je
+// putanja kvadratna u vremenu; vreme sledeceg sudara kugla-kugla, kugla-ivica
+// i upada u dzep se racuna tacno (koreni polinoma), a kugle se pomeraju
+// analiticki do tog trenutka. Dogadjaji su u redu sa prioritetom i ponistavaju
+// se lenjo: svaka kugla ima verziju koja se poveca kad joj se promeni kretanje.
+//
+// Privlacenje dzepa nema zatvoren oblik, pa se kugla u zoni privlacenja
+// pomera u malim koracima pullStep (samo ta kugla, samo dok je u zoni).
+// Kad pullStep i dt diskretnog koraka teze nuli, oba daju isti raspored.
+//
+// Van zone privlacenja dogadjaji se traze za ivice i temena guma blizu putanje
+// (upit u SegmentBVH). Celi guma oko usta dzepa su svi unutar te zone, pa se tamo
+// ivica proverava preko BoundaryField-a posle svakog koraka pullStep, kao u
+// Physics::handleWallCollision.
+
+// Kugla koja je upala u dzep tokom simulacije
+struct PocketedBall {
+    int ball;
+    int pocket;
+    double time;
+};
+
+class EventSimulator {
+public:
+    EventSimulator();
+
+    void setPullStep(double step) { pullStep = step; }
+    void setMaxEvents(int count) { maxEvents = count; }
+
+    // Simulira dok se sve kugle ne zaustave ili do maxTime sekundi.
+    // Stanje u balls se menja na mestu; vraca simulirano vreme.
+    double run(BallSystem& balls, const Table& table, double maxTime = 120.0);
+
+    int getEventCount() const { return eventCount; }
+
+    // Da li su se sve kugle zaustavile (false ako je prekinuto zbog maxTime ili maxEvents)
+    bool hasSettled() const { return settled; }
+
+    // Kugle koje su upale u poslednjem run-u, redom kojim su upale
+    const std::vector<PocketedBall>& getPocketed() const { return pocketed; }
+
+private:
+    enum EventType {
+        BallBall,     // a, b kugle
+        Cushion,      // a kugla, b ivica gume (indeks u SegmentBVH::getSegments)
+        PocketZone,   // a kugla, b dzep - ulazak u zonu privlacenja
+        Capture,      // a kugla, b dzep
+        Horizon       // a kugla - zaustavljanje ili kraj koraka privlacenja
+    };
+
+    struct Event {
+        double time;
+        EventType type;
+        int a, b;
+        int versionA, versionB;
+    };
+
+    struct Later {
+        bool operator()(const Event& lhs, const Event& rhs) const;
+    };
+
+    void setup(BallSystem& balls, const Table& table);
+    void finish(BallSystem& balls, double time);
+
+    void advance(int i, double time);
+    void setMotion(int i);
+    void setMotion(int i, int pocket);
+    void predict(int i);
+    void predictPair(int i, int j);
+    void predictCushions(int i, double horizon);
+    void push(double time, EventType type, int a, int b);
+
+    void resolveBallBall(int i, int j);
+    void resolveCushion(int i, int segment);
+    void resolvePocketZone(int i, int pocket);
+    void resolveCapture(int i);
+    void resolveHorizon(int i);
+
+    int pullPocketFor(int i) const;
+    void resolveBoundary(int i);
+
+    const Table* table;
+    double now;
+    double pullStep;
+    double deceleration;
+    double pullAcceleration;
+    int eventCount;
+    int maxEvents;
+    bool settled;
+
+    // Kretanje svake kugle od trenutka t0: p(t) = p + v*(t-t0) + a*(t-t0)^2/2 do tEnd
+    std::vector<double> t0, px, py, vx, vy, ax, ay, tEnd, radius;
+    std::vector<double> tStop;    // kada se kugla zaustavlja ako je nista ne udari
+    std::vector<int> version;
+    std::vector<int> pullPocket;  // dzep cija zona privlaci kuglu, -1 ako nijedan
+    std::vector<bool> active;
+    std::vector<PocketedBall> pocketed;
+
+    std::priority_queue<Event, std::vector<Event>, Later> queue;
+};
+
+#endif
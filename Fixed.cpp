@@ -0,0 +1,25 @@
+#include "Fixed.h"
+
+Fixed Fixed::sqrt(Fixed value) {
+    if (value.raw <= 0) return fromRaw(0);
+
+    // sqrt(raw / 2^16) * 2^16 = sqrt(raw * 2^16), computed with the classic
+    // digit-by-digit method so no floating point is involved
+    uint64_t n = (uint64_t)value.raw << FRACTION_BITS;
+    uint64_t result = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+    while (bit > n) bit >>= 2;
+
+    while (bit != 0) {
+        if (n >= result + bit) {
+            n -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return fromRaw((int32_t)result);
+}
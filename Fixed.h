@@ -0,0 +1,65 @@
+#ifndef FIXED_H
+#define FIXED_H
+
+#include <cstdint>
+
+// Broj sa fiksnom tackom Q16.16 (16 bita celog dela, 16 bita razlomka).
+// Sve operacije su celobrojne, pa je rezultat isti na svakom kompajleru i
+// procesoru, bez obzira na optimizacije, -ffast-math ili FMA.
+// Mnozenje i deljenje idu preko 64-bitnog medjurezultata; mnozenje odseca ka -beskonacno, deljenje ka nuli.
+// Opseg je oko +-32767, a najmanji korak 1/65536.
+class Fixed {
+public:
+    static const int FRACTION_BITS = 16;
+    static const int32_t ONE = 1 << FRACTION_BITS;
+
+    // Podrazumevani konstruktor je trivijalan (kao kod float-a) da bi Fixed mogao u AlignedArray
+    Fixed() = default;
+    Fixed(int value) : raw(value * ONE) {}
+
+    // Pretvaranje iz float/double je mnozenje stepenom dvojke i odsecanje, pa je i ono tacno
+    Fixed(float value) : raw((int32_t)(value * (float)ONE)) {}
+    Fixed(double value) : raw((int32_t)(value * (double)ONE)) {}
+
+    static Fixed fromRaw(int32_t raw) {
+        Fixed f;
+        f.raw = raw;
+        return f;
+    }
+
+    int32_t getRaw() const { return raw; }
+
+    explicit operator float() const { return (float)raw * (1.0f / ONE); }
+    explicit operator double() const { return (double)raw * (1.0 / ONE); }
+
+    // Celobrojni koren (bit po bit), tacan do poslednjeg bita razlomka
+    static Fixed sqrt(Fixed value);
+
+    Fixed operator-() const { return fromRaw(-raw); }
+
+    Fixed& operator+=(Fixed other) { raw += other.raw; return *this; }
+    Fixed& operator-=(Fixed other) { raw -= other.raw; return *this; }
+    Fixed& operator*=(Fixed other) { *this = *this * other; return *this; }
+    Fixed& operator/=(Fixed other) { *this = *this / other; return *this; }
+
+    friend Fixed operator+(Fixed a, Fixed b) { return fromRaw(a.raw + b.raw); }
+    friend Fixed operator-(Fixed a, Fixed b) { return fromRaw(a.raw - b.raw); }
+    friend Fixed operator*(Fixed a, Fixed b) {
+        return fromRaw((int32_t)(((int64_t)a.raw * b.raw) >> FRACTION_BITS));
+    }
+    friend Fixed operator/(Fixed a, Fixed b) {
+        return fromRaw((int32_t)(((int64_t)a.raw * ONE) / b.raw));
+    }
+
+    friend bool operator==(Fixed a, Fixed b) { return a.raw == b.raw; }
+    friend bool operator!=(Fixed a, Fixed b) { return a.raw != b.raw; }
+    friend bool operator<(Fixed a, Fixed b) { return a.raw < b.raw; }
+    friend bool operator>(Fixed a, Fixed b) { return a.raw > b.raw; }
+    friend bool operator<=(Fixed a, Fixed b) { return a.raw <= b.raw; }
+    friend bool operator>=(Fixed a, Fixed b) { return a.raw >= b.raw; }
+
+private:
+    int32_t raw;
+};
+
+#endif
@@ -0,0 +1,137 @@
+#include "JobSystem.h"
+#include <cassert>
+
+// Which worker of which system the current thread is; the thread that created
+// the system (the main thread) acts as worker 0
+static thread_local const JobSystem* localSystem = nullptr;
+static thread_local int localWorker = 0;
+
+JobSystem::JobSystem(int workerCount)
+    : workerCount(workerCount), owner(std::this_thread::get_id()), queuedTasks(0), stopping(false) {
+    if (this->workerCount <= 0) this->workerCount = (int)std::thread::hardware_concurrency();
+    if (this->workerCount <= 0) this->workerCount = 1;
+
+    for (int worker = 0; worker < this->workerCount; ++worker) {
+        queues.emplace_back(new WorkerQueue());
+    }
+    for (int worker = 1; worker < this->workerCount; ++worker) {
+        threads.emplace_back(&JobSystem::workerLoop, this, worker);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    sleepCondition.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+int JobSystem::currentWorker() const {
+    if (localSystem == this) return localWorker;
+
+    // A second outside thread would share worker 0's queue and scratch
+    assert(std::this_thread::get_id() == owner);
+    return 0;
+}
+
+void JobSystem::submit(JobGroup& group, Job job) {
+    group.pending.fetch_add(1, std::memory_order_relaxed);
+
+    WorkerQueue& queue = *queues[currentWorker()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(Task{ std::move(job), &group });
+    }
+
+    queuedTasks.fetch_add(1, std::memory_order_release);
+    {
+        // Taking the lock orders this with a worker that is about to sleep
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    sleepCondition.notify_one();
+    waitCondition.notify_all();
+}
+
+bool JobSystem::popLocal(int worker, Task& task) {
+    WorkerQueue& queue = *queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) return false;
+
+    // Newest first - its data is most likely still in this core's cache
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool JobSystem::steal(int worker, Task& task) {
+    for (int k = 1; k < workerCount; ++k) {
+        WorkerQueue& queue = *queues[(worker + k) % workerCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) continue;
+
+        // Oldest first - usually the biggest remaining piece of the victim's work
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+bool JobSystem::runOne(int worker) {
+    Task task;
+    if (!popLocal(worker, task) && !steal(worker, task)) return false;
+
+    queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+    task.job(worker);
+    if (task.group->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        // Last job of the group; the lock orders this with a wait() about to sleep
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+        waitCondition.notify_all();
+    }
+    return true;
+}
+
+void JobSystem::workerLoop(int worker) {
+    localSystem = this;
+    localWorker = worker;
+
+    for (;;) {
+        if (runOne(worker)) continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepCondition.wait(lock, [&] { return stopping || queuedTasks.load(std::memory_order_acquire) > 0; });
+        if (stopping) return;
+    }
+}
+
+void JobSystem::wait(JobGroup& group) {
+    int worker = currentWorker();
+    while (!group.isDone()) {
+        if (runOne(worker)) continue;
+
+        // Nothing left to steal: the group's remaining jobs are running elsewhere
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        waitCondition.wait(lock, [&] { return group.isDone() || queuedTasks.load(std::memory_order_acquire) > 0; });
+    }
+}
+
+bool JobSystem::help() {
+    return runOne(currentWorker());
+}
+
+void JobSystem::parallelFor(size_t count, size_t grain, const std::function<void(int worker, size_t begin, size_t end)>& body) {
+    if (grain == 0) grain = 1;
+
+    JobGroup group;
+    for (size_t begin = 0; begin < count; begin += grain) {
+        size_t end = begin + grain < count ? begin + grain : count;
+        submit(group, [&body, begin, end](int worker) { body(worker, begin, end); });
+    }
+    wait(group);
+}
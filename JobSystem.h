@@ -0,0 +1,91 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Grupa poslova na koju se ceka; broji poslove koji jos nisu zavrseni.
+// Posao moze da doda nove poslove u svoju grupu (nastavak) pre nego sto se zavrsi.
+class JobGroup {
+public:
+    JobGroup() : pending(0) {}
+
+    bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+    std::atomic<int> pending;
+};
+
+// Raspodela poslova sa kradjom (work stealing). Svaki radnik ima svoj red:
+// svoje poslove uzima sa kraja (poslednji dodat, topao u kesu), a kad mu red
+// ostane prazan krade sa pocetka tudjeg reda. Tako se dugi i kratki poslovi
+// sami rasporede i nijedno jezgro ne ceka dok drugo ima posla.
+// Nit koja je napravila sistem je radnik 0 i radi dok ceka u wait(); ona je jedina
+// spoljna nit koja sme da zove submit, wait i help (scratch[0] je njen).
+class JobSystem {
+public:
+    // Posao dobija indeks radnika koji ga izvrsava (za lokalni scratch)
+    typedef std::function<void(int worker)> Job;
+
+    // workerCount 0 = broj jezgara
+    explicit JobSystem(int workerCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    int getWorkerCount() const { return workerCount; }
+
+    // Dodaje posao u red tekuceg radnika (iz posla) ili radnika 0 (spolja)
+    void submit(JobGroup& group, Job job);
+
+    // Izvrsava poslove (svoje i ukradene) dok se grupa ne zavrsi; kad nema sta da
+    // ukrade, spava dok se grupa ne zavrsi ili ne stigne novi posao
+    void wait(JobGroup& group);
+
+    // Izvrsava najvise jedan posao na pozivajucoj niti; false ako nije bilo posla.
+    // Za rad u okviru vremena frejma umesto cekanja cele grupe.
+    bool help();
+
+    // [0, count) podeljeno na delove od po grain elemenata, svaki kao zaseban posao
+    void parallelFor(size_t count, size_t grain, const std::function<void(int worker, size_t begin, size_t end)>& body);
+
+private:
+    struct Task {
+        Job job;
+        JobGroup* group;
+    };
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    int currentWorker() const;
+    bool popLocal(int worker, Task& task);
+    bool steal(int worker, Task& task);
+    bool runOne(int worker);
+    void workerLoop(int worker);
+
+    int workerCount;
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> threads;
+
+    std::thread::id owner;
+
+    std::mutex sleepMutex;
+    std::condition_variable sleepCondition;
+    std::condition_variable waitCondition;    // wait(): grupa zavrsena ili novi posao
+    std::atomic<int> queuedTasks;
+    bool stopping;
+};
+
+#endif
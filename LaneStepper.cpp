@@ -0,0 +1,491 @@
+#include "LaneStepper.h"
+#include "BoundaryField.h"
+#include "PocketGrid.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(SIMD_X86)
+#include <immintrin.h>
+#endif
+
+LaneStepper::LaneStepper() : LaneStepper(Simd::bestPath()) {}
+
+LaneStepper::LaneStepper(Simd::Path path) : path(path), ballCount(0) {
+    // Lanes are 8 tables wide, so there is no SSE2 variant
+    if (path != Simd::Path::AVX2 || !Simd::hasAVX2()) this->path = Simd::Path::Scalar;
+    std::fill(laneLive, laneLive + LANES, 0);
+    std::fill(laneRestSteps, laneRestSteps + LANES, 0);
+    std::fill(laneSteps, laneSteps + LANES, 0);
+    std::fill(laneResult, laneResult + LANES, nullptr);
+}
+
+void LaneStepper::loadLane(int lane, const BallSystem& balls, Physics::ShotResult* result) {
+    for (int b = 0; b < ballCount; ++b) {
+        size_t k = (size_t)b * LANES + lane;
+        bool present = b < (int)balls.size();
+        x[k] = present ? balls.x[b] : Real(0.0f);
+        y[k] = present ? balls.y[b] : Real(0.0f);
+        vx[k] = present ? balls.vx[b] : Real(0.0f);
+        vy[k] = present ? balls.vy[b] : Real(0.0f);
+        radius[k] = present ? balls.radius[b] : Real(0.0f);
+        active[k] = present && balls.active[b] ? -1 : 0;
+    }
+
+    *result = Physics::ShotResult();
+    laneResult[lane] = result;
+    laneLive[lane] = -1;
+    laneRestSteps[lane] = 0;
+    laneSteps[lane] = 0;
+}
+
+void LaneStepper::storeLane(int lane, BallSystem& balls) const {
+    for (size_t b = 0; b < balls.size(); ++b) {
+        size_t k = b * LANES + lane;
+        balls.x[b] = x[k];
+        balls.y[b] = y[k];
+        balls.vx[b] = vx[k];
+        balls.vy[b] = vy[k];
+        balls.setActive(b, active[k] != 0);
+    }
+    balls.wakeAll();
+    balls.storePreviousPositions();
+}
+
+void LaneStepper::recordPocketed(int laneMask, int ball, int pocket, float dt) {
+    for (int l = 0; l < LANES; ++l) {
+        if (laneMask & (1 << l)) laneResult[l]->pocketed.push_back({ ball, pocket, laneSteps[l] * (double)dt });
+    }
+}
+
+// Same operations in the same order as Physics::updatePhysics, one lane at a time
+void LaneStepper::stepScalar(const Table& table, float dt) {
+    const Real stepDt = dt;
+    const Real friction = table.physics.frictionDeceleration() * dt;
+    const Real pullStrength = Physics::POCKET_PULL * dt * Physics::REFERENCE_STEP_RATE;
+    const BoundaryField& boundary = table.getBoundary();
+    const PocketGrid& pocketGrid = table.getPocketGrid();
+
+    for (int l = 0; l < LANES; ++l) {
+        if (!laneLive[l]) continue;
+
+        for (int b = 0; b < ballCount; ++b) {
+            size_t k = (size_t)b * LANES + l;
+            if (!active[k]) continue;
+            x[k] += vx[k] * stepDt;
+            y[k] += vy[k] * stepDt;
+        }
+
+        for (int b = 0; b < ballCount; ++b) {
+            size_t k = (size_t)b * LANES + l;
+            if (!active[k]) continue;
+            int pocket = Physics::sweepBall(x[k], y[k], vx[k], vy[k], radius[k], table, dt);
+            if (pocket < 0) continue;
+            active[k] = 0;
+            vx[k] = vy[k] = 0.0f;
+            x[k] = y[k] = -10.0f;
+            recordPocketed(1 << l, b, pocket, dt);
+        }
+
+        for (int b = 0; b < ballCount; ++b) {
+            size_t k = (size_t)b * LANES + l;
+            if (!active[k]) continue;
+            Real speed = realSqrt(vx[k] * vx[k] + vy[k] * vy[k]);
+            Real newSpeed = std::max(speed - friction, Real(0.0f));
+            Real ratio = newSpeed / std::max(speed, Real(0.0001f));
+            ratio = speed > 0.0001f ? ratio : Real(0.0f);
+            vx[k] *= ratio;
+            vy[k] *= ratio;
+        }
+
+        for (int i = 0; i < ballCount; ++i) {
+            for (int j = i + 1; j < ballCount; ++j) {
+                size_t a = (size_t)i * LANES + l;
+                size_t c = (size_t)j * LANES + l;
+                if (!active[a] || !active[c]) continue;
+
+                Real dx = x[c] - x[a];
+                Real dy = y[c] - y[a];
+                Real dist = realSqrt(dx * dx + dy * dy);
+                Real minDist = radius[a] + radius[c];
+                if (!(dist < minDist && dist > 0.0001f)) continue;
+
+                Real nx = dx / dist;
+                Real ny = dy / dist;
+                Real overlap = minDist - dist;
+                x[a] -= nx * overlap * 0.5f;
+                y[a] -= ny * overlap * 0.5f;
+                x[c] += nx * overlap * 0.5f;
+                y[c] += ny * overlap * 0.5f;
+
+                Real dvx = vx[c] - vx[a];
+                Real dvy = vy[c] - vy[a];
+                Real dvn = dvx * nx + dvy * ny;
+                if (dvn > 0) continue;
+
+                Real impulse = dvn * table.physics.collisionDamping;
+                vx[a] += impulse * nx;
+                vy[a] += impulse * ny;
+                vx[c] -= impulse * nx;
+                vy[c] -= impulse * ny;
+            }
+        }
+
+        for (int b = 0; b < ballCount; ++b) {
+            size_t k = (size_t)b * LANES + l;
+            if (!active[k]) continue;
+
+            // Only the pocket the grid names for this cell can act, as in Physics
+            int cell = pocketGrid.pocketAt(toFloat(x[k]), toFloat(y[k]), toFloat(radius[k]));
+            size_t first = cell >= 0 ? (size_t)cell : 0;
+            size_t last = cell >= 0 ? (size_t)cell + 1 : cell == PocketGrid::SEVERAL ? table.pockets.size() : 0;
+            for (size_t p = first; p < last && active[k]; ++p) {
+                const Pocket& pocket = table.pockets[p];
+                Real dx = pocket.x - x[k];
+                Real dy = pocket.y - y[k];
+                Real dist = realSqrt(dx * dx + dy * dy);
+
+                if (dist < pocket.radius * Physics::POCKET_CAPTURE) {
+                    active[k] = 0;
+                    vx[k] = vy[k] = 0.0f;
+                    x[k] = y[k] = -10.0f;
+                    recordPocketed(1 << l, b, (int)p, dt);
+                    break;
+                }
+                if (dist < pocket.radius + radius[k]) {
+                    vx[k] += (dx / dist) * pullStrength;
+                    vy[k] += (dy / dist) * pullStrength;
+                }
+            }
+            if (!active[k]) continue;
+
+            BoundarySample edge = boundary.sample(x[k], y[k]);
+            Real penetration = radius[k] + edge.distance;
+            if (penetration <= 0) continue;
+
+            x[k] -= penetration * edge.nx;
+            y[k] -= penetration * edge.ny;
+            Real vn = vx[k] * edge.nx + vy[k] * edge.ny;
+            if (vn > 0) {
+                Real bounce = vn * (1.0f + table.physics.collisionDamping);
+                vx[k] -= bounce * edge.nx;
+                vy[k] -= bounce * edge.ny;
+            }
+        }
+    }
+}
+
+#if defined(SIMD_X86)
+
+// x = mask ? value : x
+SIMD_TARGET_AVX2
+static inline __m256 blend(__m256 mask, __m256 value, __m256 x) {
+    return _mm256_blendv_ps(x, value, mask);
+}
+
+// Bilinear field value at 8 points from the lower left node of each cell, same order as BoundaryField::sample
+SIMD_TARGET_AVX2
+static inline __m256 gatherBilinear(const float* v, __m256i node, __m256i columns, __m256 fx, __m256 fy) {
+    const __m256i next = _mm256_set1_epi32(1);
+    __m256i above = _mm256_add_epi32(node, columns);
+    __m256 v00 = _mm256_i32gather_ps(v, node, 4);
+    __m256 v10 = _mm256_i32gather_ps(v, _mm256_add_epi32(node, next), 4);
+    __m256 v01 = _mm256_i32gather_ps(v, above, 4);
+    __m256 v11 = _mm256_i32gather_ps(v, _mm256_add_epi32(above, next), 4);
+    __m256 lower = _mm256_add_ps(v00, _mm256_mul_ps(_mm256_sub_ps(v10, v00), fx));
+    __m256 upper = _mm256_add_ps(v01, _mm256_mul_ps(_mm256_sub_ps(v11, v01), fx));
+    return _mm256_add_ps(lower, _mm256_mul_ps(_mm256_sub_ps(upper, lower), fy));
+}
+
+SIMD_TARGET_AVX2
+void LaneStepper::stepAVX2(const Table& table, float dt) {
+    float* px = x.data();
+    float* py = y.data();
+    float* pvx = vx.data();
+    float* pvy = vy.data();
+    const float* pr = radius.data();
+    float* pactive = reinterpret_cast<float*>(active.data());
+
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 restSpeed = _mm256_set1_ps(0.0001f);
+    const __m256 coarse = _mm256_set1_ps(1.01f);  // squared pre-test margin, far above rounding error
+    const __m256 damping = _mm256_set1_ps(table.physics.collisionDamping);
+    const __m256 bounceScale = _mm256_set1_ps(1.0f + table.physics.collisionDamping);
+    const __m256 stepDt = _mm256_set1_ps(dt);
+    const __m256 stepDt2 = _mm256_set1_ps(dt * dt);
+    const __m256 sweepMargin = _mm256_set1_ps(0.98f);   // Physics::sweepBall makes the exact test
+    const __m256 friction = _mm256_set1_ps(table.physics.frictionDeceleration() * dt);
+    const __m256 pullStrength = _mm256_set1_ps(Physics::POCKET_PULL * dt * Physics::REFERENCE_STEP_RATE);
+    const __m256 live = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(laneLive)));
+
+    const BoundaryField& boundary = table.getBoundary();
+    const float* fieldDistance = boundary.getDistances();
+    const float* fieldNormalX = boundary.getNormalsX();
+    const float* fieldNormalY = boundary.getNormalsY();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 fieldOriginX = _mm256_set1_ps(boundary.getOriginX());
+    const __m256 fieldOriginY = _mm256_set1_ps(boundary.getOriginY());
+    const __m256 fieldInverseCell = _mm256_set1_ps(boundary.getInverseCell());
+    const __m256 fieldMaxColumn = _mm256_set1_ps(boundary.getMaxColumn());
+    const __m256 fieldMaxRow = _mm256_set1_ps(boundary.getMaxRow());
+    const __m256i fieldColumns = _mm256_set1_epi32(boundary.getColumns());
+
+    // Integration and friction; lanes that are pocketed or settled keep their values
+    for (int b = 0; b < ballCount; ++b) {
+        size_t k = (size_t)b * LANES;
+        __m256 mask = _mm256_and_ps(_mm256_load_ps(pactive + k), live);
+        __m256 bx = _mm256_load_ps(px + k);
+        __m256 by = _mm256_load_ps(py + k);
+        __m256 bvx = _mm256_load_ps(pvx + k);
+        __m256 bvy = _mm256_load_ps(pvy + k);
+
+        bx = blend(mask, _mm256_add_ps(bx, _mm256_mul_ps(bvx, stepDt)), bx);
+        by = blend(mask, _mm256_add_ps(by, _mm256_mul_ps(bvy, stepDt)), by);
+
+        // Balls that moved about their radius or more take the scalar sweep, one lane at a time
+        __m256 travel2 = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(bvx, bvx), _mm256_mul_ps(bvy, bvy)), stepDt2);
+        __m256 br = _mm256_load_ps(pr + k);
+        int fast = _mm256_movemask_ps(_mm256_and_ps(mask,
+            _mm256_cmp_ps(travel2, _mm256_mul_ps(_mm256_mul_ps(br, br), sweepMargin), _CMP_GT_OQ)));
+        if (fast) {
+            _mm256_store_ps(px + k, bx);
+            _mm256_store_ps(py + k, by);
+            for (int l = 0; l < LANES; ++l) {
+                if (!(fast & (1 << l))) continue;
+                int pocket = Physics::sweepBall(x[k + l], y[k + l], vx[k + l], vy[k + l], radius[k + l], table, dt);
+                if (pocket < 0) continue;
+                active[k + l] = 0;
+                vx[k + l] = vy[k + l] = 0.0f;
+                x[k + l] = y[k + l] = -10.0f;
+                recordPocketed(1 << l, b, pocket, dt);
+            }
+            mask = _mm256_and_ps(_mm256_load_ps(pactive + k), live);
+            bx = _mm256_load_ps(px + k);
+            by = _mm256_load_ps(py + k);
+            bvx = _mm256_load_ps(pvx + k);
+            bvy = _mm256_load_ps(pvy + k);
+        }
+
+        __m256 speed = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(bvx, bvx), _mm256_mul_ps(bvy, bvy)));
+        __m256 newSpeed = _mm256_max_ps(zero, _mm256_sub_ps(speed, friction));
+        __m256 ratio = _mm256_div_ps(newSpeed, _mm256_max_ps(restSpeed, speed));
+        ratio = _mm256_and_ps(ratio, _mm256_cmp_ps(speed, restSpeed, _CMP_GT_OQ));
+        bvx = blend(mask, _mm256_mul_ps(bvx, ratio), bvx);
+        bvy = blend(mask, _mm256_mul_ps(bvy, ratio), bvy);
+
+        _mm256_store_ps(px + k, bx);
+        _mm256_store_ps(py + k, by);
+        _mm256_store_ps(pvx + k, bvx);
+        _mm256_store_ps(pvy + k, bvy);
+    }
+
+    // Ball pairs in brute force order, every lane resolving the same pair
+    for (int i = 0; i < ballCount; ++i) {
+        size_t a = (size_t)i * LANES;
+        for (int j = i + 1; j < ballCount; ++j) {
+            size_t c = (size_t)j * LANES;
+            __m256 mask = _mm256_and_ps(_mm256_and_ps(_mm256_load_ps(pactive + a), _mm256_load_ps(pactive + c)), live);
+            if (_mm256_movemask_ps(mask) == 0) continue;
+
+            __m256 ax = _mm256_load_ps(px + a), ay = _mm256_load_ps(py + a);
+            __m256 cx = _mm256_load_ps(px + c), cy = _mm256_load_ps(py + c);
+            __m256 dx = _mm256_sub_ps(cx, ax);
+            __m256 dy = _mm256_sub_ps(cy, ay);
+            __m256 dist2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+            __m256 minDist = _mm256_add_ps(_mm256_load_ps(pr + a), _mm256_load_ps(pr + c));
+
+            // Most pairs are far apart - skip the sqrt unless some lane is near contact
+            __m256 reach = _mm256_mul_ps(minDist, coarse);
+            if (_mm256_movemask_ps(_mm256_and_ps(mask, _mm256_cmp_ps(dist2, _mm256_mul_ps(reach, reach), _CMP_LT_OQ))) == 0) continue;
+            __m256 dist = _mm256_sqrt_ps(dist2);
+
+            mask = _mm256_and_ps(mask, _mm256_cmp_ps(dist, minDist, _CMP_LT_OQ));
+            mask = _mm256_and_ps(mask, _mm256_cmp_ps(dist, restSpeed, _CMP_GT_OQ));
+            if (_mm256_movemask_ps(mask) == 0) continue;
+
+            __m256 nx = _mm256_div_ps(dx, dist);
+            __m256 ny = _mm256_div_ps(dy, dist);
+            __m256 overlap = _mm256_sub_ps(minDist, dist);
+            __m256 shiftX = _mm256_mul_ps(_mm256_mul_ps(nx, overlap), half);
+            __m256 shiftY = _mm256_mul_ps(_mm256_mul_ps(ny, overlap), half);
+            _mm256_store_ps(px + a, blend(mask, _mm256_sub_ps(ax, shiftX), ax));
+            _mm256_store_ps(py + a, blend(mask, _mm256_sub_ps(ay, shiftY), ay));
+            _mm256_store_ps(px + c, blend(mask, _mm256_add_ps(cx, shiftX), cx));
+            _mm256_store_ps(py + c, blend(mask, _mm256_add_ps(cy, shiftY), cy));
+
+            __m256 avx = _mm256_load_ps(pvx + a), avy = _mm256_load_ps(pvy + a);
+            __m256 cvx = _mm256_load_ps(pvx + c), cvy = _mm256_load_ps(pvy + c);
+            __m256 dvn = _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(cvx, avx), nx),
+                _mm256_mul_ps(_mm256_sub_ps(cvy, avy), ny));
+
+            // Separating pairs only get the positional correction
+            mask = _mm256_andnot_ps(_mm256_cmp_ps(dvn, zero, _CMP_GT_OQ), mask);
+            __m256 impulse = _mm256_mul_ps(dvn, damping);
+            __m256 ix = _mm256_mul_ps(impulse, nx);
+            __m256 iy = _mm256_mul_ps(impulse, ny);
+            _mm256_store_ps(pvx + a, blend(mask, _mm256_add_ps(avx, ix), avx));
+            _mm256_store_ps(pvy + a, blend(mask, _mm256_add_ps(avy, iy), avy));
+            _mm256_store_ps(pvx + c, blend(mask, _mm256_sub_ps(cvx, ix), cvx));
+            _mm256_store_ps(pvy + c, blend(mask, _mm256_sub_ps(cvy, iy), cvy));
+        }
+    }
+
+    // Pockets, then the boundary field for balls still on the table
+    for (int b = 0; b < ballCount; ++b) {
+        size_t k = (size_t)b * LANES;
+        __m256 mask = _mm256_and_ps(_mm256_load_ps(pactive + k), live);
+        if (_mm256_movemask_ps(mask) == 0) continue;
+
+        __m256 bx = _mm256_load_ps(px + k);
+        __m256 by = _mm256_load_ps(py + k);
+        __m256 bvx = _mm256_load_ps(pvx + k);
+        __m256 bvy = _mm256_load_ps(pvy + k);
+        __m256 br = _mm256_load_ps(pr + k);
+        __m256 captured = zero;
+
+        for (size_t p = 0; p < table.pockets.size(); ++p) {
+            const Pocket& pocket = table.pockets[p];
+            __m256 pocketRadius = _mm256_set1_ps(pocket.radius);
+            __m256 dx = _mm256_sub_ps(_mm256_set1_ps(pocket.x), bx);
+            __m256 dy = _mm256_sub_ps(_mm256_set1_ps(pocket.y), by);
+            __m256 dist2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+
+            // Capture and pull both lie within pocket radius + r
+            __m256 reach = _mm256_mul_ps(_mm256_add_ps(pocketRadius, br), coarse);
+            if (_mm256_movemask_ps(_mm256_and_ps(mask, _mm256_cmp_ps(dist2, _mm256_mul_ps(reach, reach), _CMP_LT_OQ))) == 0) continue;
+            __m256 dist = _mm256_sqrt_ps(dist2);
+
+            __m256 capture = _mm256_and_ps(mask,
+                _mm256_cmp_ps(dist, _mm256_set1_ps(pocket.radius * Physics::POCKET_CAPTURE), _CMP_LT_OQ));
+            int captureBits = _mm256_movemask_ps(capture);
+            if (captureBits) {
+                recordPocketed(captureBits, b, (int)p, dt);
+                captured = _mm256_or_ps(captured, capture);
+                mask = _mm256_andnot_ps(capture, mask);
+            }
+
+            __m256 pull = _mm256_and_ps(mask, _mm256_cmp_ps(dist, _mm256_add_ps(pocketRadius, br), _CMP_LT_OQ));
+            bvx = blend(pull, _mm256_add_ps(bvx, _mm256_mul_ps(_mm256_div_ps(dx, dist), pullStrength)), bvx);
+            bvy = blend(pull, _mm256_add_ps(bvy, _mm256_mul_ps(_mm256_div_ps(dy, dist), pullStrength)), bvy);
+        }
+
+        bx = blend(captured, _mm256_set1_ps(-10.0f), bx);
+        by = blend(captured, _mm256_set1_ps(-10.0f), by);
+        bvx = blend(captured, zero, bvx);
+        bvy = blend(captured, zero, bvy);
+        _mm256_store_ps(pactive + k, _mm256_andnot_ps(captured, _mm256_load_ps(pactive + k)));
+
+        // BoundaryField::sample for 8 lanes: same clamps, gathers and bilinear order
+        __m256 gx = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(bx, fieldOriginX), fieldInverseCell), zero), fieldMaxColumn);
+        __m256 gy = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(by, fieldOriginY), fieldInverseCell), zero), fieldMaxRow);
+        __m256i column = _mm256_cvttps_epi32(gx);
+        __m256i row = _mm256_cvttps_epi32(gy);
+        __m256 fx = _mm256_sub_ps(gx, _mm256_cvtepi32_ps(column));
+        __m256 fy = _mm256_sub_ps(gy, _mm256_cvtepi32_ps(row));
+        __m256i node = _mm256_add_epi32(_mm256_mullo_epi32(row, fieldColumns), column);
+
+        __m256 penetration = _mm256_add_ps(br, gatherBilinear(fieldDistance, node, fieldColumns, fx, fy));
+        __m256 contact = _mm256_and_ps(mask, _mm256_cmp_ps(penetration, zero, _CMP_GT_OQ));
+        if (_mm256_movemask_ps(contact)) {
+            __m256 nx = gatherBilinear(fieldNormalX, node, fieldColumns, fx, fy);
+            __m256 ny = gatherBilinear(fieldNormalY, node, fieldColumns, fx, fy);
+            __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(nx, nx), _mm256_mul_ps(ny, ny)));
+            __m256 scale = _mm256_and_ps(_mm256_cmp_ps(length, zero, _CMP_GT_OQ), _mm256_div_ps(one, length));
+            nx = _mm256_mul_ps(nx, scale);
+            ny = _mm256_mul_ps(ny, scale);
+
+            bx = blend(contact, _mm256_sub_ps(bx, _mm256_mul_ps(penetration, nx)), bx);
+            by = blend(contact, _mm256_sub_ps(by, _mm256_mul_ps(penetration, ny)), by);
+            __m256 vn = _mm256_add_ps(_mm256_mul_ps(bvx, nx), _mm256_mul_ps(bvy, ny));
+            __m256 bounce = _mm256_mul_ps(vn, bounceScale);
+            __m256 hit = _mm256_and_ps(contact, _mm256_cmp_ps(vn, zero, _CMP_GT_OQ));
+            bvx = blend(hit, _mm256_sub_ps(bvx, _mm256_mul_ps(bounce, nx)), bvx);
+            bvy = blend(hit, _mm256_sub_ps(bvy, _mm256_mul_ps(bounce, ny)), bvy);
+        }
+
+        _mm256_store_ps(px + k, bx);
+        _mm256_store_ps(py + k, by);
+        _mm256_store_ps(pvx + k, bvx);
+        _mm256_store_ps(pvy + k, bvy);
+    }
+}
+
+#else
+
+void LaneStepper::stepAVX2(const Table& table, float dt) {
+    stepScalar(table, dt);
+}
+
+#endif
+
+bool LaneStepper::updateRest(int lane, float dt, int maxSteps) {
+    bool moving = false;
+    for (int b = 0; b < ballCount && !moving; ++b) {
+        size_t k = (size_t)b * LANES + lane;
+        Real speed2 = vx[k] * vx[k] + vy[k] * vy[k];
+        moving = active[k] && speed2 > Physics::SLEEP_SPEED * Physics::SLEEP_SPEED;
+    }
+
+    Physics::ShotResult& result = *laneResult[lane];
+    laneRestSteps[lane] = moving ? 0 : laneRestSteps[lane] + 1;
+    result.events = laneSteps[lane];
+    result.duration = laneSteps[lane] * (double)dt;
+    result.settled = laneRestSteps[lane] >= Physics::SLEEP_STEPS;
+    return result.settled || laneSteps[lane] >= maxSteps;
+}
+
+void LaneStepper::run(BallSystem* tables, Physics::ShotResult* results, int count,
+    const Table& table, float dt, double maxTime) {
+    ballCount = 0;
+    for (int t = 0; t < count; ++t) {
+        ballCount = std::max(ballCount, (int)tables[t].size());
+    }
+
+    size_t n = (size_t)ballCount * LANES;
+    x.resize(n);
+    y.resize(n);
+    vx.resize(n);
+    vy.resize(n);
+    radius.resize(n);
+    active.resize(n);
+    std::fill(active.data(), active.data() + n, 0);
+
+    // Which table each lane holds; a lane whose table settles takes the next one
+    int laneTable[LANES];
+    int next = 0;
+    int live = 0;
+    for (int l = 0; l < LANES; ++l) {
+        laneLive[l] = 0;
+        laneTable[l] = -1;
+        if (next < count) {
+            laneTable[l] = next;
+            loadLane(l, tables[next], &results[next]);
+            next++;
+            live++;
+        }
+    }
+
+    int maxSteps = (int)std::ceil(maxTime / dt);
+    while (live > 0) {
+        for (int l = 0; l < LANES; ++l) {
+            if (laneLive[l]) laneSteps[l]++;
+        }
+
+        if (path == Simd::Path::AVX2) stepAVX2(table, dt);
+        else stepScalar(table, dt);
+
+        for (int l = 0; l < LANES; ++l) {
+            if (!laneLive[l] || !updateRest(l, dt, maxSteps)) continue;
+
+            storeLane(l, tables[laneTable[l]]);
+            laneLive[l] = 0;
+            live--;
+            if (next < count) {
+                laneTable[l] = next;
+                loadLane(l, tables[next], &results[next]);
+                next++;
+                live++;
+            }
+        }
+    }
+}
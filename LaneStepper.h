@@ -0,0 +1,56 @@
+#ifndef LANE_STEPPER_H
+#define LANE_STEPPER_H
+
+#include "BallSystem.h"
+#include "Table.h"
+#include "Physics.h"
+#include "Simd.h"
+#include <cstdint>
+
+// Simulira LANES stolova odjednom: ista kugla iz svih stolova je u jednom
+// AVX2 registru (sto = traka), pa integracija, trenje, sudari kugli, dzepovi i
+// ivice idu za svih 8 stolova istim instrukcijama. Upale kugle i stolovi koji
+// su se smirili su iskljuceni maskom, a traka ciji se sto smirio odmah dobija
+// sledeci sto iz serije. Za iste pocetne uslove daje bit-identicno stanje kao
+// Physics::runToRest sa brute force grubom fazom.
+//
+// Namenjeno za isti raspored sa mnogo varijacija udarca (npr. 7 kugli iz setupBalls).
+// Sto se smatra mirnim kad su mu sve kugle SLEEP_STEPS koraka sporije od SLEEP_SPEED.
+class LaneStepper {
+public:
+    static const int LANES = 8;
+
+    LaneStepper();
+    explicit LaneStepper(Simd::Path path);
+
+    // Simulira count stolova do mirovanja ili maxTime. Stanja se menjaju na mestu,
+    // a results[k] dobija ishod stola tables[k]. Stolovi mogu imati razlicit broj
+    // kugli (visak je neaktivan).
+    void run(BallSystem* tables, Physics::ShotResult* results, int count,
+        const Table& table, float dt, double maxTime = 120.0);
+
+    // AVX2 ili Scalar (ista logika traka po traka)
+    Simd::Path getPath() const { return path; }
+
+private:
+    void loadLane(int lane, const BallSystem& balls, Physics::ShotResult* result);
+    void storeLane(int lane, BallSystem& balls) const;
+    void stepScalar(const Table& table, float dt);
+    void stepAVX2(const Table& table, float dt);
+    void recordPocketed(int laneMask, int ball, int pocket, float dt);
+    bool updateRest(int lane, float dt, int maxSteps);
+
+    Simd::Path path;
+    int ballCount;
+
+    // Vrednost kugle b u traci l je na indeksu b * LANES + l
+    AlignedArray<Real> x, y, vx, vy, radius;
+    AlignedArray<int32_t> active;  // -1 (svi bitovi) aktivna, 0 upala ili nema kugle
+
+    int32_t laneLive[LANES];       // -1 dok se sto u traci jos krece
+    int laneRestSteps[LANES];
+    int laneSteps[LANES];
+    Physics::ShotResult* laneResult[LANES];
+};
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+// Fajl mapiran u memoriju samo za citanje (mmap na POSIX-u, CreateFileMapping
+// na Windows-u). Stranice ucitava sistem po potrebi i dele se izmedju procesa
+// koji otvore isti fajl.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return data != nullptr; }
+    const unsigned char* getData() const { return static_cast<const unsigned char*>(data); }
+    size_t getSize() const { return size; }
+
+private:
+    const void* data;
+    size_t size;
+
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+};
+
+#endif
@@ -0,0 +1,137 @@
+#include "Narrowphase.h"
+
+#if defined(SIMD_X86)
+#include <immintrin.h>
+#endif
+
+static_assert(sizeof(BallPair) == 2 * sizeof(int), "BallPair must be two packed ints for the AVX2 loads");
+
+Narrowphase::Narrowphase() : path(Simd::bestPath()) {}
+
+Narrowphase::Narrowphase(Simd::Path path) : path(path) {
+    // Never run a path the CPU can't execute
+    if (path == Simd::Path::AVX2 && !Simd::hasAVX2()) this->path = Simd::bestPath();
+    if (path == Simd::Path::SSE2 && !Simd::hasSSE2()) this->path = Simd::Path::Scalar;
+}
+
+static void findContactsScalar(const BallSystem& balls, const BallPair* pairs, size_t begin, size_t end,
+    std::vector<BallPair>& contacts) {
+    const Real* x = balls.x.data();
+    const Real* y = balls.y.data();
+    const Real* radius = balls.radius.data();
+
+    for (size_t k = begin; k < end; ++k) {
+        int i = pairs[k].i;
+        int j = pairs[k].j;
+        Real dx = x[j] - x[i];
+        Real dy = y[j] - y[i];
+        Real reach = (radius[i] + radius[j]) * NARROWPHASE_CONTACT_REACH;
+        if (dx * dx + dy * dy < reach * reach) {
+            contacts.push_back(pairs[k]);
+        }
+    }
+}
+
+#if defined(SIMD_X86)
+
+static void appendMasked(const BallPair* pairs, size_t first, int mask, std::vector<BallPair>& contacts) {
+    while (mask) {
+        int bit = 0;
+        while (!(mask & (1 << bit))) ++bit;
+        contacts.push_back(pairs[first + bit]);
+        mask &= mask - 1;
+    }
+}
+
+SIMD_TARGET_SSE2
+static void findContactsSSE2(const BallSystem& balls, const BallPair* pairs, size_t count,
+    std::vector<BallPair>& contacts) {
+    const float* x = balls.x.data();
+    const float* y = balls.y.data();
+    const float* radius = balls.radius.data();
+    const __m128 reachScale = _mm_set1_ps(NARROWPHASE_CONTACT_REACH);
+
+    size_t k = 0;
+    for (; k + 4 <= count; k += 4) {
+        const BallPair* p = pairs + k;
+        __m128 xi = _mm_set_ps(x[p[3].i], x[p[2].i], x[p[1].i], x[p[0].i]);
+        __m128 yi = _mm_set_ps(y[p[3].i], y[p[2].i], y[p[1].i], y[p[0].i]);
+        __m128 ri = _mm_set_ps(radius[p[3].i], radius[p[2].i], radius[p[1].i], radius[p[0].i]);
+        __m128 xj = _mm_set_ps(x[p[3].j], x[p[2].j], x[p[1].j], x[p[0].j]);
+        __m128 yj = _mm_set_ps(y[p[3].j], y[p[2].j], y[p[1].j], y[p[0].j]);
+        __m128 rj = _mm_set_ps(radius[p[3].j], radius[p[2].j], radius[p[1].j], radius[p[0].j]);
+
+        __m128 dx = _mm_sub_ps(xj, xi);
+        __m128 dy = _mm_sub_ps(yj, yi);
+        __m128 dist2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        __m128 reach = _mm_mul_ps(_mm_add_ps(ri, rj), reachScale);
+
+        int mask = _mm_movemask_ps(_mm_cmplt_ps(dist2, _mm_mul_ps(reach, reach)));
+        appendMasked(pairs, k, mask, contacts);
+    }
+
+    findContactsScalar(balls, pairs, k, count, contacts);
+}
+
+SIMD_TARGET_AVX2
+static void findContactsAVX2(const BallSystem& balls, const BallPair* pairs, size_t count,
+    std::vector<BallPair>& contacts) {
+    const float* x = balls.x.data();
+    const float* y = balls.y.data();
+    const float* radius = balls.radius.data();
+    const __m256 reachScale = _mm256_set1_ps(NARROWPHASE_CONTACT_REACH);
+
+    size_t k = 0;
+    for (; k + 8 <= count; k += 8) {
+        // 8 pairs are 16 interleaved ints: i0 j0 i1 j1 ... - split them into i and j vectors
+        __m256 lo = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pairs + k)));
+        __m256 hi = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pairs + k + 4)));
+        __m256i idxI = _mm256_castps_si256(_mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)));
+        __m256i idxJ = _mm256_castps_si256(_mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1)));
+        idxI = _mm256_permute4x64_epi64(idxI, _MM_SHUFFLE(3, 1, 2, 0));
+        idxJ = _mm256_permute4x64_epi64(idxJ, _MM_SHUFFLE(3, 1, 2, 0));
+
+        __m256 xi = _mm256_i32gather_ps(x, idxI, 4);
+        __m256 yi = _mm256_i32gather_ps(y, idxI, 4);
+        __m256 ri = _mm256_i32gather_ps(radius, idxI, 4);
+        __m256 xj = _mm256_i32gather_ps(x, idxJ, 4);
+        __m256 yj = _mm256_i32gather_ps(y, idxJ, 4);
+        __m256 rj = _mm256_i32gather_ps(radius, idxJ, 4);
+
+        __m256 dx = _mm256_sub_ps(xj, xi);
+        __m256 dy = _mm256_sub_ps(yj, yi);
+        __m256 dist2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        __m256 reach = _mm256_mul_ps(_mm256_add_ps(ri, rj), reachScale);
+
+        int mask = _mm256_movemask_ps(_mm256_cmp_ps(dist2, _mm256_mul_ps(reach, reach), _CMP_LT_OQ));
+        appendMasked(pairs, k, mask, contacts);
+    }
+
+    findContactsScalar(balls, pairs, k, count, contacts);
+}
+
+#endif
+
+const std::vector<BallPair>& Narrowphase::findContacts(const BallSystem& balls, const std::vector<BallPair>& candidates) {
+    contacts.clear();
+    if (candidates.empty()) return contacts;
+
+    const BallPair* pairs = candidates.data();
+    size_t count = candidates.size();
+
+    switch (path) {
+#if defined(SIMD_X86)
+    case Simd::Path::AVX2:
+        findContactsAVX2(balls, pairs, count, contacts);
+        break;
+    case Simd::Path::SSE2:
+        findContactsSSE2(balls, pairs, count, contacts);
+        break;
+#endif
+    default:
+        findContactsScalar(balls, pairs, 0, count, contacts);
+        break;
+    }
+
+    return contacts;
+}
@@ -0,0 +1,37 @@
+#ifndef NARROWPHASE_H
+#define NARROWPHASE_H
+
+#include "BallSystem.h"
+#include "Broadphase.h"
+#include "Simd.h"
+#include <vector>
+
+// Koliko dalje od zbira radijusa par i dalje ide na razresavanje sudara.
+// Grube faze vec koriste isti razmak (jedan radijus za pomeranje pri razdvajanju),
+// pa par koji se priblizi tokom istog koraka nece biti odbacen.
+const float NARROWPHASE_CONTACT_REACH = 1.5f;
+
+// Uska faza u paketima: testira 4 (SSE2) ili 8 (AVX2) parova odjednom
+// preko kvadrata rastojanja, bez korena. Dalje idu samo parovi na dohvat
+// kontakta, istim redom kao na ulazu, a handleBallCollision ih razresava kao i pre.
+//
+// Tolerancija: test je isti izraz (dx*dx + dy*dy < reach*reach) u svim
+// putanjama, pa je rezultat identican skalarnom osim kad kompajler spoji
+// mnozenje i sabiranje (FMA) u skalarnoj verziji - tada se parovi na samoj
+// granici reach mogu razlikovati za ~1 ulp, sto ne menja razresene kontakte
+// jer je reach vec veci od stvarnog rastojanja kontakta.
+class Narrowphase {
+public:
+    Narrowphase();
+    explicit Narrowphase(Simd::Path path);
+
+    const std::vector<BallPair>& findContacts(const BallSystem& balls, const std::vector<BallPair>& candidates);
+
+    Simd::Path getPath() const { return path; }
+
+private:
+    Simd::Path path;
+    std::vector<BallPair> contacts;
+};
+
+#endif
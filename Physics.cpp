@@ -1,116 +1,481 @@
 #include "Physics.h"
+#include "BoundaryField.h"
+#include "PocketGrid.h"
+#include "SegmentBVH.h"
 #include "Header/Util.h"
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 namespace Physics {
 
-    // Reduced friction (was 0.02f, now 0.005f)
+    // Friction and pocket pull are per-step amounts tuned at REFERENCE_STEP_RATE,
+    // scaled by dt so the result converges as dt shrinks.
 
-    void handleBallCollision(Ball& ball1, Ball& ball2) {
-        if (!ball1.active || !ball2.active) return;
+    bool handleBallCollision(BallSystem& balls, int i, int j, const PhysicsParams& params) {
+        BallRef ball1 = balls[i];
+        BallRef ball2 = balls[j];
+        if (!ball1.active || !ball2.active) return false;
 
-        float dx = ball2.x - ball1.x;
-        float dy = ball2.y - ball1.y;
-        float dist = length(dx, dy);
-        float minDist = ball1.radius + ball2.radius;
+        Real dx = ball2.x - ball1.x;
+        Real dy = ball2.y - ball1.y;
+        Real dist = length(dx, dy);
+        Real minDist = ball1.radius + ball2.radius;
 
         if (dist < minDist && dist > 0.0001f) {
-            float nx = dx / dist;
-            float ny = dy / dist;
+            Real nx = dx / dist;
+            Real ny = dy / dist;
 
-            float overlap = minDist - dist;
+            Real overlap = minDist - dist;
             ball1.x -= nx * overlap * 0.5f;
             ball1.y -= ny * overlap * 0.5f;
             ball2.x += nx * overlap * 0.5f;
             ball2.y += ny * overlap * 0.5f;
 
-            float dvx = ball2.vx - ball1.vx;
-            float dvy = ball2.vy - ball1.vy;
-            float dvn = dot(dvx, dvy, nx, ny);
+            Real dvx = ball2.vx - ball1.vx;
+            Real dvy = ball2.vy - ball1.vy;
+            Real dvn = dot(dvx, dvy, nx, ny);
 
-            if (dvn > 0) return;
+            if (dvn > 0) return true;
 
-            float impulse = dvn * COLLISION_DAMPING;
+            Real impulse = dvn * params.collisionDamping;
             ball1.vx += impulse * nx;
             ball1.vy += impulse * ny;
             ball2.vx -= impulse * nx;
             ball2.vy -= impulse * ny;
+            return true;
         }
+        return false;
     }
 
-    void handleWallCollision(Ball& ball, const Table& table) {
+    void handleWallCollision(BallSystem& balls, int i, const Table& table) {
+        BallRef ball = balls[i];
         if (!ball.active) return;
 
-        float cushion = table.cushionThickness;
+        // Rails and pocket jaws come from the baked field: depth and normal in one lookup
+        BoundarySample edge = table.getBoundary().sample(ball.x, ball.y);
+        Real penetration = ball.radius + edge.distance;
+        if (penetration <= 0) return;
 
-        // Check if ball is near a pocket - if so, skip wall collision
-        for (const auto& pocket : table.pockets) {
-            float distToPocket = distance(ball.x, ball.y, pocket.x, pocket.y);
-            if (distToPocket < pocket.radius + ball.radius * 2) {
-                return;
+        ball.x -= penetration * edge.nx;
+        ball.y -= penetration * edge.ny;
+
+        // Only the normal part of the velocity bounces, and only if it points into the cushion
+        Real vn = ball.vx * edge.nx + ball.vy * edge.ny;
+        if (vn > 0) {
+            Real bounce = vn * (1.0f + table.physics.collisionDamping);
+            ball.vx -= bounce * edge.nx;
+            ball.vy -= bounce * edge.ny;
+        }
+    }
+
+    // Earliest t in [0, 1] at which a point moving from (x, y) along the unit direction (ux, uy)
+    // for travel reaches distance reach from (cx, cy), coming from outside; -1 if it starts
+    // inside or never gets there. Only lengths are squared after dividing by reach, so the
+    // result keeps its precision in Fixed as well.
+    static Real entryTime(Real x, Real y, Real ux, Real uy, Real travel, Real cx, Real cy, Real reach) {
+        Real fx = cx - x;
+        Real fy = cy - y;
+        Real along = fx * ux + fy * uy;
+        Real across = fx * uy - fy * ux;
+        if (along <= 0 || across >= reach || -across >= reach) return -1.0f;
+
+        Real h = across / reach;
+        Real entry = along - reach * realSqrt(Real(1.0f) - h * h);
+        if (entry <= 0 || entry > travel) return -1.0f;
+        return entry / travel;
+    }
+
+    int sweepBall(Real& x, Real& y, Real& vx, Real& vy, Real radius, const Table& table, float dt) {
+        const Real r = radius;
+        Real dx = vx * dt;
+        Real dy = vy * dt;
+        if (dx * dx + dy * dy <= r * r) return -1;
+
+        // The whole sweep is in Real (segment and pocket data are converted once per use),
+        // so it is as deterministic as the rest of the step with PHYSICS_FIXED_POINT
+        const SegmentBVH& tree = table.getCushionTree();
+        const std::vector<CushionSegment>& segments = tree.getSegments();
+        Real vxs = vx;
+        Real vys = vy;
+        Real px = x - dx;
+        Real py = y - dy;
+        Real remaining = dt;
+        bool bounced = false;
+
+        for (int bounce = 0; bounce <= SWEEP_MAX_BOUNCES; ++bounce) {
+            // Path length relative to its longer side, so the squares neither lose
+            // precision nor overflow in Fixed
+            Real longer = std::max(dx < 0 ? -dx : dx, dy < 0 ? -dy : dy);
+            if (longer <= 0) break;
+            Real travel = longer * length(dx / longer, dy / longer);
+            Real ux = dx / travel;
+            Real uy = dy / travel;
+
+            // Earliest of: a cushion face, a cushion vertex (jaw tip), a pocket capture disc.
+            // Only segments near the swept path are tested.
+            Real first = 2.0f;
+            Real nx = 0.0f, ny = 0.0f;
+            int pocket = -1;
+
+            tree.querySegment(toFloat(px), toFloat(py), toFloat(px + dx), toFloat(py + dy), toFloat(r) * 1.01f, [&](int k) {
+                const CushionSegment& segment = segments[k];
+                Real x0 = segment.x0, y0 = segment.y0;
+                Real snx = segment.nx, sny = segment.ny;
+
+                // The face: the center stays one radius off the line on the cloth side
+                Real side = (px - x0) * snx + (py - y0) * sny;
+                Real approach = dx * snx + dy * sny;
+                if (side < -r && approach > 0) {
+                    Real t = (-r - side) / approach;
+                    // Along the segment, whose direction is the normal turned to the left
+                    Real along = (px + dx * t - x0) * -sny + (py + dy * t - y0) * snx;
+                    Real end = (Real(segment.x1) - x0) * -sny + (Real(segment.y1) - y0) * snx;
+                    if (t < first && along >= 0 && along <= end) {
+                        first = t;
+                        nx = snx;
+                        ny = sny;
+                        pocket = -1;
+                    }
+                }
+
+                // Cushions are closed loops, so every vertex starts exactly one segment
+                Real t = entryTime(px, py, ux, uy, travel, x0, y0, r);
+                if (t >= 0 && t < first) {
+                    first = t;
+                    nx = (x0 - (px + dx * t)) / r;
+                    ny = (y0 - (py + dy * t)) / r;
+                    pocket = -1;
+                }
+            });
+            for (size_t k = 0; k < table.pockets.size(); ++k) {
+                const Pocket& p = table.pockets[k];
+                Real t = entryTime(px, py, ux, uy, travel, p.x, p.y, p.radius * POCKET_CAPTURE);
+                if (t >= 0 && t < first) {
+                    first = t;
+                    pocket = (int)k;
+                }
+            }
+
+            if (pocket >= 0) return pocket;
+            if (first > 1.0f) {
+                // Nothing in the way; a clear sweep leaves the integrated step untouched
+                if (!bounced) return -1;
+                px += dx;
+                py += dy;
+                break;
+            }
+
+            px += dx * first;
+            py += dy * first;
+            remaining *= Real(1.0f) - first;
+            bounced = true;
+
+            // Out of bounces: the ball stays at the contact and loses its speed into the cushion
+            Real vn = vxs * nx + vys * ny;
+            if (bounce == SWEEP_MAX_BOUNCES) {
+                if (vn > 0) {
+                    vxs -= vn * nx;
+                    vys -= vn * ny;
+                }
+                break;
+            }
+
+            // Same bounce as handleWallCollision, then the rest of the step with the new velocity
+            if (vn > 0) {
+                Real scale = vn * (1.0f + table.physics.collisionDamping);
+                vxs -= scale * nx;
+                vys -= scale * ny;
             }
+            dx = vxs * remaining;
+            dy = vys * remaining;
         }
 
-        if (ball.x - ball.radius < table.left + cushion) {
-            ball.x = table.left + cushion + ball.radius;
-            ball.vx = -ball.vx * COLLISION_DAMPING;
+        x = px;
+        y = py;
+        vx = vxs;
+        vy = vys;
+        return -1;
+    }
+
+    // Takes the ball off the table
+    static void pocketBall(BallSystem& balls, int i) {
+        BallRef ball = balls[i];
+        balls.setActive(i, false);
+        ball.stop();
+        ball.x = -10.0f;
+        ball.y = -10.0f;
+    }
+
+    // Capture or pull by one pocket; returns true if the ball fell in
+    static bool applyPocket(BallSystem& balls, int i, const Pocket& pocket, float dt) {
+        BallRef ball = balls[i];
+        Real dist = distance(ball.x, ball.y, pocket.x, pocket.y);
+
+        // Ball falls into pocket if center is close enough to pocket center
+        if (dist < pocket.radius * POCKET_CAPTURE) {
+            pocketBall(balls, i);
+            return true;
         }
-        if (ball.x + ball.radius > table.right - cushion) {
-            ball.x = table.right - cushion - ball.radius;
-            ball.vx = -ball.vx * COLLISION_DAMPING;
+
+        // Gravity towards pocket - pulls ball when nearby
+        if (dist < pocket.radius + ball.radius) {
+            Real pullStrength = POCKET_PULL * dt * REFERENCE_STEP_RATE;
+            Real dx = pocket.x - ball.x;
+            Real dy = pocket.y - ball.y;
+            ball.vx += (dx / dist) * pullStrength;
+            ball.vy += (dy / dist) * pullStrength;
+            balls.restSteps[i] = 0;
         }
-        if (ball.y + ball.radius > table.top - cushion) {
-            ball.y = table.top - cushion - ball.radius;
-            ball.vy = -ball.vy * COLLISION_DAMPING;
+        return false;
+    }
+
+    void handlePocketCollision(BallSystem& balls, int i, const Table& table, float dt) {
+        if (!balls.active[i]) return;
+
+        // Away from the pockets this is the only check; near one, only that pocket is measured
+        int k = table.getPocketGrid().pocketAt(toFloat(balls.x[i]), toFloat(balls.y[i]), toFloat(balls.radius[i]));
+        if (k == PocketGrid::NONE) return;
+        if (k != PocketGrid::SEVERAL) {
+            applyPocket(balls, i, table.pockets[k], dt);
+            return;
         }
-        if (ball.y - ball.radius < table.bottom + cushion) {
-            ball.y = table.bottom + cushion + ball.radius;
-            ball.vy = -ball.vy * COLLISION_DAMPING;
+        for (const auto& pocket : table.pockets) {
+            if (applyPocket(balls, i, pocket, dt)) return;
         }
     }
 
-    void handlePocketCollision(Ball& ball, const Table& table) {
-        if (!ball.active) return;
+    static void integrateBalls(BallSystem& balls, const Table& table, float dt) {
+        balls.integrate(dt);
 
-        for (const auto& pocket : table.pockets) {
-            float dist = distance(ball.x, ball.y, pocket.x, pocket.y);
-
-            // Ball falls into pocket if center is close enough to pocket center
-            if (dist < pocket.radius * 0.7f) {
-                ball.active = false;
-                ball.stop();
-                ball.x = -10.0f;
-                ball.y = -10.0f;
-                return;
+        // Fast balls are swept back over the step so they cannot jump a cushion or a pocket
+        for (int i : balls.awakeBalls()) {
+            if (sweepBall(balls.x[i], balls.y[i], balls.vx[i], balls.vy[i], balls.radius[i], table, dt) >= 0) {
+                pocketBall(balls, i);
             }
+        }
 
-            // Gravity towards pocket - pulls ball when nearby
-            if (dist < pocket.radius + ball.radius) {
-                float pullStrength = 0.02f;
-                float dx = pocket.x - ball.x;
-                float dy = pocket.y - ball.y;
-                ball.vx += (dx / dist) * pullStrength;
-                ball.vy += (dy / dist) * pullStrength;
-            }
+        balls.applyFriction(table.physics.frictionDeceleration() * dt);
+    }
+
+    static void handleTableCollisions(BallSystem& balls, const Table& table, float dt) {
+        for (int i : balls.awakeBalls()) {
+            handlePocketCollision(balls, i, table, dt);
+            handleWallCollision(balls, i, table);
         }
     }
 
-    void updatePhysics(std::vector<Ball>& balls, const Table& table, float dt) {
-        for (auto& ball : balls) {
-            ball.update(dt);
-            ball.applyFriction(1.0f - FRICTION);
+    // A contact with a sleeping ball wakes its whole island; returns true if it did
+    static bool resolveContact(BallSystem& balls, int i, int j, const PhysicsParams& params) {
+        if (!handleBallCollision(balls, i, j, params)) return false;
+        if (!balls.asleep[i] && !balls.asleep[j]) return false;
+        if (balls.asleep[i]) balls.wake(i);
+        if (balls.asleep[j]) balls.wake(j);
+        return true;
+    }
+
+    static bool pairLess(const BallPair& a, const BallPair& b) {
+        return a.i != b.i ? a.i < b.i : a.j < b.j;
+    }
+
+    // Pairs of two sleeping balls are left out of the candidate list. When a contact
+    // wakes an island mid-step the list is rebuilt and resolution continues after the
+    // current pair, the same as the brute force loop, which checks sleep as it goes.
+    static const std::vector<BallPair>& resolvePairs(BallSystem& balls, const Table& table,
+        Broadphase& broadphase, Narrowphase* narrowphase) {
+        auto findContacts = [&]() -> const std::vector<BallPair>& {
+            const std::vector<BallPair>& candidates = broadphase.findPairs(balls, table);
+            return narrowphase ? narrowphase->findContacts(balls, candidates) : candidates;
+        };
+
+        const std::vector<BallPair>* pairs = &findContacts();
+        for (size_t k = 0; k < pairs->size(); ++k) {
+            BallPair pair = (*pairs)[k];
+            if (!resolveContact(balls, pair.i, pair.j, table.physics)) continue;
+
+            pairs = &findContacts();
+            k = std::upper_bound(pairs->begin(), pairs->end(), pair, pairLess) - pairs->begin() - 1;
         }
+        return *pairs;
+    }
+
+    static bool touching(const BallSystem& balls, int i, int j) {
+        Real dx = balls.x[j] - balls.x[i];
+        Real dy = balls.y[j] - balls.y[i];
+        Real reach = (balls.radius[i] + balls.radius[j]) * 1.01f;
+        return dx * dx + dy * dy < reach * reach;
+    }
+
+    // Puts slow balls to sleep and joins sleeping balls that touch into islands.
+    // pairs are this step's candidates; without them every ball is checked.
+    static void updateSleep(BallSystem& balls, const std::vector<BallPair>* pairs) {
+        const std::vector<int>& awake = balls.awakeBalls();
+        bool anyAsleep = false;
+        for (int i : awake) {
+            Real speed2 = balls.vx[i] * balls.vx[i] + balls.vy[i] * balls.vy[i];
+            if (speed2 > SLEEP_SPEED * SLEEP_SPEED) {
+                balls.restSteps[i] = 0;
+            }
+            else if (++balls.restSteps[i] >= SLEEP_STEPS) {
+                balls.sleep(i);
+                anyAsleep = true;
+            }
+        }
+        if (!anyAsleep) return;
+
+        if (pairs) {
+            for (const auto& pair : *pairs) {
+                if (balls.asleep[pair.i] && balls.asleep[pair.j] && touching(balls, pair.i, pair.j)) {
+                    balls.joinIslands(pair.i, pair.j);
+                }
+            }
+            return;
+        }
+
+        for (size_t i = 0; i < balls.size(); ++i) {
+            if (!balls.active[i] || !balls.asleep[i]) continue;
+            for (size_t j = i + 1; j < balls.size(); ++j) {
+                if (balls.active[j] && balls.asleep[j] && touching(balls, (int)i, (int)j)) {
+                    balls.joinIslands(i, j);
+                }
+            }
+        }
+    }
+
+    void updatePhysics(BallSystem& balls, const Table& table, float dt) {
+        integrateBalls(balls, table, dt);
 
         for (size_t i = 0; i < balls.size(); ++i) {
             for (size_t j = i + 1; j < balls.size(); ++j) {
-                handleBallCollision(balls[i], balls[j]);
+                if (balls.asleep[i] && balls.asleep[j]) continue;
+                resolveContact(balls, (int)i, (int)j, table.physics);
             }
         }
 
-        for (auto& ball : balls) {
-            handlePocketCollision(ball, table);
-            handleWallCollision(ball, table);
+        handleTableCollisions(balls, table, dt);
+        updateSleep(balls, nullptr);
+    }
+
+    void updatePhysics(BallSystem& balls, const Table& table, float dt, Broadphase& broadphase) {
+        integrateBalls(balls, table, dt);
+
+        const std::vector<BallPair>& pairs = resolvePairs(balls, table, broadphase, nullptr);
+
+        handleTableCollisions(balls, table, dt);
+        updateSleep(balls, &pairs);
+    }
+
+    void updatePhysics(BallSystem& balls, const Table& table, float dt, Broadphase& broadphase, Narrowphase& narrowphase) {
+        integrateBalls(balls, table, dt);
+
+        const std::vector<BallPair>& contacts = resolvePairs(balls, table, broadphase, &narrowphase);
+
+        handleTableCollisions(balls, table, dt);
+        updateSleep(balls, &contacts);
+    }
+
+    int substepCount(const BallSystem& balls, float dt, float maxTravel) {
+        // Compared in Real against whole substep counts, so under PHYSICS_FIXED_POINT
+        // no float rounding near an integer boundary can change the count between builds
+        Real step = dt;
+        if (!(step > 0)) return 1;
+        Real perSecond = (Real)maxTravel / step;
+
+        int substeps = 1;
+        for (int i : balls.awakeBalls()) {
+            // Speed one substep allows for this ball; a small ball counts as fast sooner
+            Real reach = perSecond * balls.radius[i];
+            if (!(reach > 0)) return MAX_SUBSTEPS;
+            Real vx = balls.vx[i] < 0 ? -balls.vx[i] : balls.vx[i];
+            Real vy = balls.vy[i] < 0 ? -balls.vy[i] : balls.vy[i];
+            // Checked before dividing, so the squared ratio below stays in range in Fixed
+            if (std::max(vx, vy) >= reach * MAX_SUBSTEPS) return MAX_SUBSTEPS;
+
+            Real rx = vx / reach;
+            Real ry = vy / reach;
+            Real ratio = rx * rx + ry * ry;
+            while (substeps < MAX_SUBSTEPS && ratio > (Real)(substeps * substeps)) ++substeps;
         }
+        return substeps;
+    }
+
+    int updatePhysicsAdaptive(BallSystem& balls, const Table& table, float dt, Broadphase& broadphase,
+        Narrowphase& narrowphase, float maxTravel) {
+        int substeps = substepCount(balls, dt, maxTravel);
+        float substepDt = dt / substeps;
+        for (int k = 0; k < substeps; ++k) {
+            updatePhysics(balls, table, substepDt, broadphase, narrowphase);
+        }
+        return substeps;
+    }
+
+    ShotResult simulateToRest(BallSystem& balls, const Table& table, EventSimulator& simulator, double maxTime) {
+        ShotResult result;
+        result.duration = simulator.run(balls, table, maxTime);
+        result.events = simulator.getEventCount();
+        result.settled = simulator.hasSettled();
+        result.pocketed = simulator.getPocketed();
+        return result;
+    }
+
+    ShotResult simulateToRest(BallSystem& balls, const Table& table, double maxTime) {
+        EventSimulator simulator;
+        return simulateToRest(balls, table, simulator, maxTime);
+    }
+
+    void applyShot(BallSystem& balls, const Shot& shot) {
+        balls.vx[shot.ball] = std::cos(shot.angle) * shot.speed;
+        balls.vy[shot.ball] = std::sin(shot.angle) * shot.speed;
+        balls.wake(shot.ball);
+    }
+
+    static int nearestPocket(const Table& table, float x, float y) {
+        int nearest = -1;
+        float nearestDist = 0.0f;
+        for (size_t k = 0; k < table.pockets.size(); ++k) {
+            float dist = distance(x, y, table.pockets[k].x, table.pockets[k].y);
+            if (nearest < 0 || dist < nearestDist) {
+                nearest = (int)k;
+                nearestDist = dist;
+            }
+        }
+        return nearest;
+    }
+
+    bool stepTowardsRest(BallSystem& balls, const Table& table, float dt,
+        Broadphase& broadphase, Narrowphase& narrowphase, int stepLimit, double maxTime, ShotResult& result) {
+        int maxSteps = (int)std::ceil(maxTime / dt);
+
+        for (int taken = 0; taken < stepLimit; ++taken) {
+            if (balls.awakeBalls().empty()) {
+                result.settled = true;
+                return true;
+            }
+            if (result.events >= maxSteps) return true;
+
+            balls.storePreviousPositions();
+            updatePhysics(balls, table, dt, broadphase, narrowphase);
+            result.events++;
+            result.duration = result.events * (double)dt;
+
+            // A ball pocketed this step was active at its previous position, which is never -10
+            for (size_t i = 0; i < balls.size(); ++i) {
+                if (!balls.active[i] && balls.prevX[i] != balls.x[i]) {
+                    float x = toFloat(balls.prevX[i]);
+                    float y = toFloat(balls.prevY[i]);
+                    result.pocketed.push_back({ (int)i, nearestPocket(table, x, y), result.duration });
+                    balls.snapPrevious(i);
+                }
+            }
+        }
+        return false;
+    }
+
+    ShotResult runToRest(BallSystem& balls, const Table& table, float dt,
+        Broadphase& broadphase, Narrowphase& narrowphase, double maxTime) {
+        ShotResult result;
+        while (!stepTowardsRest(balls, table, dt, broadphase, narrowphase, std::numeric_limits<int>::max(), maxTime, result)) {}
+        return result;
     }
 
-}
\ No newline at end of file
+}
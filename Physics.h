@@ -1,26 +1,106 @@
 #ifndef PHYSICS_H
 #define PHYSICS_H
 
-#include "Ball.h"
+#include "BallSystem.h"
 #include "Table.h"
+#include "Broadphase.h"
+#include "Narrowphase.h"
+#include "EventSimulator.h"
 #include <vector>
 
 namespace Physics {
-    // Provera i resavanje sudara izmedu dve kugle
-    void handleBallCollision(Ball& ball1, Ball& ball2);
+    // Prilagodljivi podkoraci (updatePhysicsAdaptive): najveci put kugle po podkoraku
+    // kao deo njenog radijusa, i gornja granica broja podkoraka
+    const float SUBSTEP_TRAVEL = 0.5f;
+    const int MAX_SUBSTEPS = 64;
 
-    // Provera i resavanje sudara kugle sa zidovima stola
-    void handleWallCollision(Ball& ball, const Table& table);
+    // Ishod udarca simuliranog do kraja
+    struct ShotResult {
+        std::vector<PocketedBall> pocketed;  // upale kugle, redom
+        double duration;                     // sekundi dok se sve ne zaustavi
+        int events;                          // dogadjaja (simulateToRest) ili koraka (runToRest)
+        bool settled;                        // false ako je simulacija prekinuta pre zaustavljanja
 
-    // Provera da li je kugla usla u dzep
-    void handlePocketCollision(Ball& ball, const Table& table);
+        ShotResult() : duration(0.0), events(0), settled(false) {}
+    };
 
-    // Obraduje sve sudare u sistemu
-    void updatePhysics(std::vector<Ball>& balls, const Table& table, float dt);
+    // Udarac: kugla ball dobija brzinu speed (jedinica/s) u pravcu angle (radijani)
+    struct Shot {
+        int ball;
+        float angle;
+        float speed;
+    };
 
-    // Konstante
-    const float FRICTION = 0.98f;           // trenje (0-1, gde je 1 bez trenja)
-    const float COLLISION_DAMPING = 0.95f;  // gubitak energije pri sudaru
+    // Zadaje brzinu udarca i budi kuglu
+    void applyShot(BallSystem& balls, const Shot& shot);
+
+
+    // Provera i resavanje sudara izmedu dve kugle; vraca true ako su se dodirnule
+    bool handleBallCollision(BallSystem& balls, int i, int j, const PhysicsParams& params);
+
+    // Provera i resavanje sudara kugle sa ivicom stola (gume i vrhovi guma oko dzepova, preko BoundaryField)
+    void handleWallCollision(BallSystem& balls, int i, const Table& table);
+
+    // Kontinualna provera (CCD) za kuglu koja je u koraku presla vise od svog radijusa:
+    // put od (x, y) - v*dt do (x, y) se ponovo prolazi, pa se kugla odbija od ivice ili
+    // temena gume (ivice blizu puta daje SegmentBVH) u trenutku dodira (ostatak koraka ide
+    // odbijenom brzinom), a upada u dzep ako joj centar predje disk hvatanja. Tako ni
+    // veliki dt ne preskace gume ni dzepove.
+    // Vraca indeks dzepa u koji je kugla upala (stanje kugle tada nije menjano) ili -1.
+    // Sporije kugle i putevi bez dodira ostaju bit-identicni.
+    int sweepBall(Real& x, Real& y, Real& vx, Real& vy, Real radius, const Table& table, float dt);
+
+    // Provera da li je kugla usla u dzep (dt skalira privlacenje dzepa); dzep bira PocketGrid
+    void handlePocketCollision(BallSystem& balls, int i, const Table& table, float dt);
+
+    // Obraduje sve sudare u sistemu (brute force provera svih parova)
+    void updatePhysics(BallSystem& balls, const Table& table, float dt);
+
+    // Isto, ali parove kugli bira zadata gruba faza
+    void updatePhysics(BallSystem& balls, const Table& table, float dt, Broadphase& broadphase);
+
+    // Kandidate iz grube faze prvo filtrira SIMD uska faza, pa se razresavaju samo parovi u kontaktu
+    void updatePhysics(BallSystem& balls, const Table& table, float dt, Broadphase& broadphase, Narrowphase& narrowphase);
+
+    // Isto, ali se dt deli na jednake podkorake tako da najbrza budna kugla u podkoraku
+    // predje najvise maxTravel svog radijusa (CFL uslov); kad su sve kugle spore, to je
+    // jedan korak. Broj podkoraka se bira na pocetku poziva (najvise MAX_SUBSTEPS) i vraca.
+    int updatePhysicsAdaptive(BallSystem& balls, const Table& table, float dt, Broadphase& broadphase,
+        Narrowphase& narrowphase, float maxTravel = SUBSTEP_TRAVEL);
+
+    // Koliko podkoraka bi updatePhysicsAdaptive napravio za ovo stanje
+    int substepCount(const BallSystem& balls, float dt, float maxTravel = SUBSTEP_TRAVEL);
+
+    // Preskace animaciju: simulacija dogadjajima skace od sudara do sudara do zaustavljanja.
+    // Konacni raspored se upisuje u balls.
+    ShotResult simulateToRest(BallSystem& balls, const Table& table, double maxTime = 120.0);
+
+    // Isto, sa simulatorom koji se ponovo koristi (bez alokacija po udarcu)
+    ShotResult simulateToRest(BallSystem& balls, const Table& table, EventSimulator& simulator, double maxTime = 120.0);
+
+    // Korak po korak sa fiksnim dt dok se sve kugle ne uspavaju ili ne istekne maxTime.
+    // Sporije od simulateToRest, ali koristi isti kod kao igra (i fiksnu tacku iz Real.h).
+    // Dzep upale kugle je onaj najblizi njenoj poziciji pre koraka u kom je upala.
+    ShotResult runToRest(BallSystem& balls, const Table& table, float dt,
+        Broadphase& broadphase, Narrowphase& narrowphase, double maxTime = 120.0);
+
+    // Isto, ali najvise stepLimit koraka, pa se dugi udarac moze deliti na delove.
+    // result se nastavlja od prethodnog poziva (pocinje prazan); vraca true kad je udarac gotov.
+    bool stepTowardsRest(BallSystem& balls, const Table& table, float dt,
+        Broadphase& broadphase, Narrowphase& narrowphase, int stepLimit, double maxTime, ShotResult& result);
+
+    // Konstante (trenje i prigusenje sudara su u Table::physics)
+    const float POCKET_PULL = 0.02f;        // privlacenje dzepa po koraku
+    const float POCKET_CAPTURE = 0.7f;      // kugla upada kad joj je centar unutar ovog dela radijusa dzepa
+    const int SWEEP_MAX_BOUNCES = 4;        // odbijanja u jednom koraku; na sledecem dodiru kugla ostaje na gumi bez brzine ka njoj
+
+    // Frekvencija (75 Hz petlja u Main.cpp) za koju su trenje i privlacenje podeseni po koraku.
+    // Gubitak po koraku se skalira sa dt * REFERENCE_STEP_RATE, pa rezultat ne zavisi od dt.
+    const float REFERENCE_STEP_RATE = 75.0f;
+
+    // Kugla koja je SLEEP_STEPS uzastopnih koraka sporija od SLEEP_SPEED (jedinica/s) se uspavljuje
+    const float SLEEP_SPEED = 0.001f;
+    const int SLEEP_STEPS = 10;
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,53 @@
+#include "PhysicsParams.h"
+#include "Physics.h"
+#include <cstdio>
+#include <cstring>
+
+const float PhysicsParams::MIN_FRICTION = 0.5f;
+const float PhysicsParams::MAX_FRICTION = 1.0f;
+const float PhysicsParams::MIN_COLLISION_DAMPING = 0.0f;
+const float PhysicsParams::MAX_COLLISION_DAMPING = 1.0f;
+
+float PhysicsParams::frictionDeceleration() const {
+    return (1.0f - friction) * Physics::REFERENCE_STEP_RATE;
+}
+
+bool PhysicsParams::load(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "r");
+    if (!file) return false;
+
+    // Read into a copy, so a bad file leaves the parameters as they were
+    PhysicsParams loaded = *this;
+    bool valid = true;
+    char line[256];
+    char name[64];
+    float value;
+    while (valid && std::fgets(line, sizeof(line), file)) {
+        int fields = std::sscanf(line, "%63s %f", name, &value);
+        if (fields < 1 || name[0] == '#') continue;
+        if (fields != 2) {
+            valid = false;
+        }
+        else if (std::strcmp(name, "friction") == 0) {
+            loaded.friction = value;
+            valid = value >= MIN_FRICTION && value <= MAX_FRICTION;
+        }
+        else if (std::strcmp(name, "collisionDamping") == 0) {
+            loaded.collisionDamping = value;
+            valid = value >= MIN_COLLISION_DAMPING && value <= MAX_COLLISION_DAMPING;
+        }
+    }
+    std::fclose(file);
+
+    if (valid) *this = loaded;
+    return valid;
+}
+
+bool PhysicsParams::save(const std::string& path) const {
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) return false;
+
+    std::fprintf(file, "friction %.6f\n", friction);
+    std::fprintf(file, "collisionDamping %.6f\n", collisionDamping);
+    return std::fclose(file) == 0;
+}
@@ -0,0 +1,29 @@
+#ifndef PHYSICS_PARAMS_H
+#define PHYSICS_PARAMS_H
+
+#include <string>
+
+// Parametri fizike koji zavise od stola (tkanina, gume). Nosi ih Table, pa se
+// osecaj svakog tipa stola podesava fajlom (ili Calibrator-om) bez prevodjenja.
+struct PhysicsParams {
+    float friction;           // trenje po koraku na REFERENCE_STEP_RATE (0-1, gde je 1 bez trenja)
+    float collisionDamping;   // deo normalne brzine koji ostaje posle sudara (kugla i guma)
+
+    // Opseg u kom su parametri smisleni (trenje iznad 1 bi ubrzavalo kugle);
+    // load odbija vrednosti van njega, a Calibrator ne izlazi iz njega
+    static const float MIN_FRICTION, MAX_FRICTION;
+    static const float MIN_COLLISION_DAMPING, MAX_COLLISION_DAMPING;
+
+    PhysicsParams() : friction(0.98f), collisionDamping(0.95f) {}
+
+    // Usporenje od trenja u jedinicama/s^2
+    float frictionDeceleration() const;
+
+    // Tekstualni fajl, jedan par "ime vrednost" po redu. Nepoznata imena se preskacu,
+    // a parametri kojih nema u fajlu zadrzavaju trenutnu vrednost. Red bez vrednosti
+    // ili vrednost van opsega daje false, i tada se nijedan parametar ne menja.
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+};
+
+#endif
@@ -0,0 +1,49 @@
+#include "PocketGrid.h"
+#include <algorithm>
+#include <cmath>
+
+const float PocketGrid::CELL = 0.05f;
+const float PocketGrid::MAX_BALL_RADIUS = 0.05f;
+
+PocketGrid::PocketGrid(const Table& table) {
+    // Everything a pocket can reach, plus one cell so rounding at the border never matters
+    float minX = table.left, maxX = table.right, minY = table.bottom, maxY = table.top;
+    for (const Pocket& pocket : table.pockets) {
+        float reach = pocket.radius + MAX_BALL_RADIUS;
+        minX = std::min(minX, pocket.x - reach);
+        maxX = std::max(maxX, pocket.x + reach);
+        minY = std::min(minY, pocket.y - reach);
+        maxY = std::max(maxY, pocket.y + reach);
+    }
+    originX = minX - CELL;
+    originY = minY - CELL;
+    inverseCell = 1.0f / CELL;
+    columns = (int)std::ceil((maxX - minX) / CELL) + 2;
+    rows = (int)std::ceil((maxY - minY) / CELL) + 2;
+    cells.assign((size_t)columns * rows, (signed char)NONE);
+
+    for (size_t k = 0; k < table.pockets.size(); ++k) {
+        const Pocket& pocket = table.pockets[k];
+        float reach = pocket.radius + MAX_BALL_RADIUS;
+
+        // Cells whose rectangle comes within reach of the pocket center. The margin
+        // keeps cells whose edge is a rounding error away from the zone.
+        float margin = 1e-4f;
+        int firstColumn = std::max(0, (int)std::floor((pocket.x - reach - originX) * inverseCell) - 1);
+        int lastColumn = std::min(columns - 1, (int)std::floor((pocket.x + reach - originX) * inverseCell) + 1);
+        int firstRow = std::max(0, (int)std::floor((pocket.y - reach - originY) * inverseCell) - 1);
+        int lastRow = std::min(rows - 1, (int)std::floor((pocket.y + reach - originY) * inverseCell) + 1);
+        for (int row = firstRow; row <= lastRow; ++row) {
+            for (int column = firstColumn; column <= lastColumn; ++column) {
+                float x0 = originX + column * CELL, y0 = originY + row * CELL;
+                float nearestX = std::min(std::max(pocket.x, x0), x0 + CELL);
+                float nearestY = std::min(std::max(pocket.y, y0), y0 + CELL);
+                float dx = pocket.x - nearestX, dy = pocket.y - nearestY;
+                if (dx * dx + dy * dy >= (reach + margin) * (reach + margin)) continue;
+
+                signed char& cell = cells[(size_t)row * columns + column];
+                cell = cell == NONE ? (signed char)k : (signed char)SEVERAL;
+            }
+        }
+    }
+}
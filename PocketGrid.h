@@ -0,0 +1,40 @@
+#ifndef POCKET_GRID_H
+#define POCKET_GRID_H
+
+#include "Table.h"
+#include <vector>
+
+// Gruba mreza preko stola: svako polje pamti jedini dzep cija zona (hvatanje i
+// privlacenje, do pocket.radius + MAX_BALL_RADIUS od centra) dodiruje polje,
+// NONE ako nijedan ili SEVERAL ako se zone dva dzepa preklapaju u polju.
+// Vecina kugli je daleko od dzepova i proverava se jednim citanjem; ostale
+// racunaju rastojanje samo do jednog dzepa. Table je pravi u setupPockets.
+class PocketGrid {
+public:
+    static const float CELL;
+    static const float MAX_BALL_RADIUS;   // vece kugle dobijaju SEVERAL
+
+    static const int NONE = -1;
+    static const int SEVERAL = -2;
+
+    explicit PocketGrid(const Table& table);
+
+    // Dzep koji moze da uhvati ili privuce kuglu poluprecnika radius sa centrom u (x, y)
+    int pocketAt(float x, float y, float radius) const {
+        if (radius > MAX_BALL_RADIUS) return SEVERAL;
+        float gx = (x - originX) * inverseCell;
+        float gy = (y - originY) * inverseCell;
+        if (!(gx >= 0.0f && gy >= 0.0f)) return NONE;
+        int column = (int)gx;
+        int row = (int)gy;
+        if (column >= columns || row >= rows) return NONE;
+        return cells[row * columns + column];
+    }
+
+private:
+    int columns, rows;
+    float originX, originY, inverseCell;
+    std::vector<signed char> cells;
+};
+
+#endif
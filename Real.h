@@ -0,0 +1,42 @@
+#ifndef REAL_H
+#define REAL_H
+
+// Tip za stanje i racun fizike. Podrazumevano float; kad je definisan
+// PHYSICS_FIXED_POINT (u podesavanjima projekta ili ispod) ceo fizicki korak
+// radi u Fixed (Q16.16) i daje bit-identican rezultat na svakom buildu.
+// Ulaz (sto, parametri udarca) ostaje float i pretvara se pri upisu.
+// SIMD uska faza i simulacija dogadjajima nisu deterministicke i u tom
+// rezimu se ne koriste, odnosno rade preko konverzije.
+
+// #define PHYSICS_FIXED_POINT
+
+#include <cmath>
+
+#ifdef PHYSICS_FIXED_POINT
+
+#include "Fixed.h"
+
+typedef Fixed Real;
+
+inline float toFloat(Fixed value) { return (float)value; }
+inline Fixed realSqrt(Fixed value) { return Fixed::sqrt(value); }
+
+// Celi deo nenegativne vrednosti (npr. indeks celije mreze)
+inline int toInt(Fixed value) { return value.getRaw() >> Fixed::FRACTION_BITS; }
+
+// Isto sto i funkcije iz Header/Util.h, za Fixed
+inline Fixed length(Fixed x, Fixed y) { return Fixed::sqrt(x * x + y * y); }
+inline Fixed distance(Fixed x1, Fixed y1, Fixed x2, Fixed y2) { return length(x2 - x1, y2 - y1); }
+inline Fixed dot(Fixed x1, Fixed y1, Fixed x2, Fixed y2) { return x1 * x2 + y1 * y2; }
+
+#else
+
+typedef float Real;
+
+inline float toFloat(float value) { return value; }
+inline float realSqrt(float value) { return std::sqrt(value); }
+inline int toInt(float value) { return (int)value; }
+
+#endif
+
+#endif
@@ -0,0 +1,148 @@
+#include "SegmentBVH.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+// In double and rounded once, so the normals are the same float on every build
+// (Physics::sweepBall reads them in the fixed-point step)
+static void normalize(float& x, float& y) {
+    double length = std::sqrt((double)x * x + (double)y * y);
+    if (length > 0.0) {
+        x = (float)(x / length);
+        y = (float)(y / length);
+    }
+}
+
+SegmentBVH::SegmentBVH(const std::vector<Cushion>& cushions) {
+    for (const Cushion& cushion : cushions) {
+        const std::vector<CushionPoint>& points = cushion.points;
+        size_t n = points.size();
+        if (n < 2) continue;
+
+        // Loops are closed implicitly; the cloth is on the left, so the normal is on the right
+        size_t first = segments.size();
+        for (size_t k = 0; k < n; ++k) {
+            const CushionPoint& a = points[k];
+            const CushionPoint& b = points[(k + 1) % n];
+            float dx = b.x - a.x, dy = b.y - a.y;
+            if (dx == 0.0f && dy == 0.0f) continue;
+
+            CushionSegment segment;
+            segment.x0 = a.x;
+            segment.y0 = a.y;
+            segment.x1 = b.x;
+            segment.y1 = b.y;
+            segment.nx = dy;
+            segment.ny = -dx;
+            normalize(segment.nx, segment.ny);
+            segments.push_back(segment);
+        }
+
+        size_t count = segments.size() - first;
+        for (size_t k = 0; k < count; ++k) {
+            CushionSegment& segment = segments[first + k];
+            const CushionSegment& previous = segments[first + (k + count - 1) % count];
+            const CushionSegment& next = segments[first + (k + 1) % count];
+            segment.startNx = segment.nx + previous.nx;
+            segment.startNy = segment.ny + previous.ny;
+            segment.endNx = segment.nx + next.nx;
+            segment.endNy = segment.ny + next.ny;
+            normalize(segment.startNx, segment.startNy);
+            normalize(segment.endNx, segment.endNy);
+        }
+    }
+
+    if (segments.empty()) return;
+    nodes.reserve(2 * segments.size() / LEAF_SIZE + 2);
+    nodes.push_back(Node());
+    build(0, 0, (int)segments.size());
+}
+
+void SegmentBVH::build(int index, int begin, int end) {
+    Node node;
+    node.minX = node.minY = FLT_MAX;
+    node.maxX = node.maxY = -FLT_MAX;
+    for (int k = begin; k < end; ++k) {
+        const CushionSegment& s = segments[k];
+        node.minX = std::min(node.minX, std::min(s.x0, s.x1));
+        node.minY = std::min(node.minY, std::min(s.y0, s.y1));
+        node.maxX = std::max(node.maxX, std::max(s.x0, s.x1));
+        node.maxY = std::max(node.maxY, std::max(s.y0, s.y1));
+    }
+
+    if (end - begin <= LEAF_SIZE) {
+        node.first = begin;
+        node.count = end - begin;
+        nodes[index] = node;
+        return;
+    }
+
+    // Median split along the longer side of the box, by segment midpoint
+    bool alongX = node.maxX - node.minX >= node.maxY - node.minY;
+    int middle = (begin + end) / 2;
+    std::nth_element(segments.begin() + begin, segments.begin() + middle, segments.begin() + end,
+        [alongX](const CushionSegment& a, const CushionSegment& b) {
+            return alongX ? a.x0 + a.x1 < b.x0 + b.x1 : a.y0 + a.y1 < b.y0 + b.y1;
+        });
+
+    // Children sit next to each other; the vector may grow, so the node is written by index
+    node.first = (int)nodes.size();
+    node.count = 0;
+    nodes[index] = node;
+    nodes.push_back(Node());
+    nodes.push_back(Node());
+    build(node.first, begin, middle);
+    build(node.first + 1, middle, end);
+}
+
+SegmentHit SegmentBVH::nearest(double x, double y) const {
+    SegmentHit hit;
+    hit.segment = -1;
+    hit.distance = DBL_MAX;
+    hit.x = x;
+    hit.y = y;
+    hit.nx = hit.ny = 0.0;
+    if (nodes.empty()) return hit;
+
+    // Branch and bound: a box farther away than the best hit so far is skipped
+    auto boxDistance = [x, y](const Node& node) {
+        double dx = std::max(std::max(node.minX - x, x - node.maxX), 0.0);
+        double dy = std::max(std::max(node.minY - y, y - node.maxY), 0.0);
+        return std::sqrt(dx * dx + dy * dy);
+    };
+
+    int stack[64];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = nodes[stack[--top]];
+        if (boxDistance(node) >= hit.distance) continue;
+
+        if (node.count == 0) {
+            // Nearer child last, so it is searched first
+            int near = node.first, far = node.first + 1;
+            if (boxDistance(nodes[far]) < boxDistance(nodes[near])) std::swap(near, far);
+            stack[top++] = far;
+            stack[top++] = near;
+            continue;
+        }
+
+        for (int k = node.first; k < node.first + node.count; ++k) {
+            const CushionSegment& s = segments[k];
+            double dx = (double)s.x1 - s.x0, dy = (double)s.y1 - s.y0;
+            double t = ((x - s.x0) * dx + (y - s.y0) * dy) / (dx * dx + dy * dy);
+            t = std::min(std::max(t, 0.0), 1.0);
+            double cx = s.x0 + dx * t, cy = s.y0 + dy * t;
+            double distance = std::sqrt((x - cx) * (x - cx) + (y - cy) * (y - cy));
+            if (distance >= hit.distance) continue;
+
+            hit.segment = k;
+            hit.distance = distance;
+            hit.x = cx;
+            hit.y = cy;
+            hit.nx = t <= 0.0 ? s.startNx : t >= 1.0 ? s.endNx : s.nx;
+            hit.ny = t <= 0.0 ? s.startNy : t >= 1.0 ? s.endNy : s.ny;
+        }
+    }
+    return hit;
+}
@@ -0,0 +1,128 @@
+#ifndef SEGMENT_BVH_H
+#define SEGMENT_BVH_H
+
+#include "Table.h"
+#include <algorithm>
+#include <vector>
+
+// Jedna ivica gume od (x0, y0) do (x1, y1); normala (nx, ny) pokazuje u gumu.
+// Temena imaju pseudo-normalu (zbir normala dve susedne ivice), po kojoj se
+// zna sa koje strane temena je guma.
+struct CushionSegment {
+    float x0, y0, x1, y1;
+    float nx, ny;
+    float startNx, startNy;     // pseudo-normala temena (x0, y0)
+    float endNx, endNy;         // pseudo-normala temena (x1, y1)
+};
+
+// Najbliza tacka gume nekoj tacki
+struct SegmentHit {
+    int segment;                // -1 ako nema nijedne ivice
+    double distance;
+    double x, y;
+    double nx, ny;              // normala ivice, ili pseudo-normala ako je najbliza tacka teme
+};
+
+// Stablo obuhvatnih pravougaonika (BVH) nad ivicama svih guma stola. Ivice se
+// dele po sredini duze ose dok u listu ne ostane najvise LEAF_SIZE, pa upit za
+// oblast ili najblizu ivicu obilazi O(log n) cvorova i detaljan sto ne kosta
+// vise od pravougaonog.
+class SegmentBVH {
+public:
+    static const int LEAF_SIZE = 4;
+
+    explicit SegmentBVH(const std::vector<Cushion>& cushions);
+
+    // Ivice u redosledu stabla (indeksi iz upita vaze za ovaj niz)
+    const std::vector<CushionSegment>& getSegments() const { return segments; }
+
+    // Poziva visit(indeks) za svaku ivicu ciji pravougaonik sece zadati
+    template <typename Visit>
+    void query(float minX, float minY, float maxX, float maxY, Visit visit) const;
+
+    // Isto za put od (x0, y0) do (x1, y1) sirine radius: cvor se obilazi samo ako put
+    // sece njegov pravougaonik prosiren za radius, pa duga putanja uz gumu ne pokupi
+    // sve ivice koje stanu u njen obuhvatni pravougaonik
+    template <typename Visit>
+    void querySegment(float x0, float y0, float x1, float y1, float radius, Visit visit) const;
+
+    // Najbliza tacka na nekoj ivici
+    SegmentHit nearest(double x, double y) const;
+
+private:
+    struct Node {
+        float minX, minY, maxX, maxY;
+        int first;      // list: prva ivica; unutrasnji cvor: levo dete (desno je first + 1)
+        int count;      // broj ivica u listu, 0 za unutrasnji cvor
+    };
+
+    void build(int index, int begin, int end);
+
+    std::vector<CushionSegment> segments;
+    std::vector<Node> nodes;
+};
+
+template <typename Visit>
+void SegmentBVH::query(float minX, float minY, float maxX, float maxY, Visit visit) const {
+    if (nodes.empty()) return;
+
+    int stack[64];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = nodes[stack[--top]];
+        if (node.maxX < minX || node.minX > maxX || node.maxY < minY || node.minY > maxY) continue;
+
+        if (node.count > 0) {
+            for (int k = node.first; k < node.first + node.count; ++k) visit(k);
+        }
+        else {
+            stack[top++] = node.first;
+            stack[top++] = node.first + 1;
+        }
+    }
+}
+
+template <typename Visit>
+void SegmentBVH::querySegment(float x0, float y0, float x1, float y1, float radius, Visit visit) const {
+    if (nodes.empty()) return;
+
+    float dx = x1 - x0, dy = y1 - y0;
+    auto touches = [&](const Node& node) {
+        // Slab test: the part of [0, 1] inside each expanded side range must overlap
+        float enter = 0.0f, leave = 1.0f;
+        const float lows[2] = { node.minX - radius, node.minY - radius };
+        const float highs[2] = { node.maxX + radius, node.maxY + radius };
+        const float starts[2] = { x0, y0 };
+        const float deltas[2] = { dx, dy };
+        for (int axis = 0; axis < 2; ++axis) {
+            if (deltas[axis] == 0.0f) {
+                if (starts[axis] < lows[axis] || starts[axis] > highs[axis]) return false;
+                continue;
+            }
+            float a = (lows[axis] - starts[axis]) / deltas[axis];
+            float b = (highs[axis] - starts[axis]) / deltas[axis];
+            enter = std::max(enter, std::min(a, b));
+            leave = std::min(leave, std::max(a, b));
+        }
+        return enter <= leave;
+    };
+
+    int stack[64];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = nodes[stack[--top]];
+        if (!touches(node)) continue;
+
+        if (node.count > 0) {
+            for (int k = node.first; k < node.first + node.count; ++k) visit(k);
+        }
+        else {
+            stack[top++] = node.first;
+            stack[top++] = node.first + 1;
+        }
+    }
+}
+
+#endif
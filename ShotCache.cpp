@@ -0,0 +1,213 @@
+#include "ShotCache.h"
+#include <cmath>
+#include <cstring>
+
+ShotCache::ShotCache(size_t capacity, float positionStep, float angleStep, float speedStep)
+    : bucketCount(1), positionStep(positionStep), angleStep(angleStep), speedStep(speedStep),
+    hits(0), misses(0), evictions(0) {
+    while (bucketCount * WAYS < capacity) bucketCount *= 2;
+
+    buckets.reset(new Bucket[bucketCount]);
+    for (size_t b = 0; b < bucketCount; ++b) {
+        Bucket& bucket = buckets[b];
+        bucket.hand.store(0, std::memory_order_relaxed);
+        for (Slot& slot : bucket.slots) {
+            slot.sequence.store(0, std::memory_order_relaxed);
+            slot.referenced.store(0, std::memory_order_relaxed);
+            slot.key.store(0, std::memory_order_relaxed);
+            for (auto& word : slot.words) word.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void ShotCache::resetCounters() {
+    hits.store(0, std::memory_order_relaxed);
+    misses.store(0, std::memory_order_relaxed);
+    evictions.store(0, std::memory_order_relaxed);
+}
+
+static int32_t quantize(float value, float step) {
+    return (int32_t)std::floor(value / step + 0.5f);
+}
+
+uint64_t ShotCache::makeKey(const BallSystem& balls, const Physics::Shot& shot) const {
+    // One multiply per value instead of byte-wise FNV; the finalizer below does the avalanche
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](int64_t value) {
+        hash = (hash ^ (uint64_t)value) * 0x9E3779B97F4A7C15ULL;
+        hash ^= hash >> 32;
+    };
+
+    mix((int64_t)balls.size());
+    for (size_t i = 0; i < balls.size(); ++i) {
+        // Pocketed balls keep stale coordinates; only the flag matters for them
+        mix(balls.active[i] ? 1 : 0);
+        if (!balls.active[i]) continue;
+        mix(quantize(toFloat(balls.x[i]), positionStep));
+        mix(quantize(toFloat(balls.y[i]), positionStep));
+    }
+    mix(shot.ball);
+    mix(quantize(shot.angle, angleStep));
+    mix(quantize(shot.speed, speedStep));
+
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    return hash != 0 ? hash : 1;
+}
+
+static uint64_t packPair(float a, float b) {
+    uint32_t ua, ub;
+    std::memcpy(&ua, &a, 4);
+    std::memcpy(&ub, &b, 4);
+    return (uint64_t)ua | ((uint64_t)ub << 32);
+}
+
+static void unpackPair(uint64_t word, float& a, float& b) {
+    uint32_t ua = (uint32_t)word;
+    uint32_t ub = (uint32_t)(word >> 32);
+    std::memcpy(&a, &ua, 4);
+    std::memcpy(&b, &ub, 4);
+}
+
+// Seqlock read: the copy is only valid if the sequence was even and unchanged around it
+bool ShotCache::read(Slot& slot, uint64_t key, uint64_t* words) const {
+    uint32_t before = slot.sequence.load(std::memory_order_acquire);
+    if (before & 1) return false;
+    if (slot.key.load(std::memory_order_relaxed) != key) return false;
+
+    words[0] = slot.words[0].load(std::memory_order_relaxed);
+    int ballCount = (int)(words[0] & 0xFF);
+    int pocketedCount = (int)((words[0] >> 8) & 0xFF);
+    if (ballCount > MAX_BALLS || pocketedCount > MAX_BALLS) return false;
+
+    for (int w = 1; w < HEADER_WORDS + ballCount; ++w) {
+        words[w] = slot.words[w].load(std::memory_order_relaxed);
+    }
+    for (int p = 0; p < pocketedCount; ++p) {
+        int w = HEADER_WORDS + MAX_BALLS + p;
+        words[w] = slot.words[w].load(std::memory_order_relaxed);
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.sequence.load(std::memory_order_relaxed) == before;
+}
+
+bool ShotCache::lookup(uint64_t key, BallSystem& balls, Physics::ShotResult& result) {
+    Bucket& bucket = bucketFor(key);
+    uint64_t words[PAYLOAD_WORDS];
+
+    for (Slot& slot : bucket.slots) {
+        // A torn read is retried once; a slot rewritten twice in a row counts as a miss
+        if (!read(slot, key, words) && !read(slot, key, words)) continue;
+
+        int ballCount = (int)(words[0] & 0xFF);
+        if ((size_t)ballCount != balls.size()) continue;
+        int pocketedCount = (int)((words[0] >> 8) & 0xFF);
+        uint32_t activeMask = (uint32_t)(words[0] >> 32);
+
+        for (int i = 0; i < ballCount; ++i) {
+            float x, y;
+            unpackPair(words[HEADER_WORDS + i], x, y);
+            balls.x[i] = x;
+            balls.y[i] = y;
+            balls.vx[i] = 0.0f;
+            balls.vy[i] = 0.0f;
+            balls.active[i] = (activeMask >> i & 1u) != 0;
+        }
+        balls.wakeAll();
+
+        std::memcpy(&result.duration, &words[1], sizeof(double));
+        result.events = (int)words[2];
+        result.settled = ((words[0] >> 16) & 1) != 0;
+        result.pocketed.clear();
+        for (int p = 0; p < pocketedCount; ++p) {
+            uint64_t word = words[HEADER_WORDS + MAX_BALLS + p];
+            float time;
+            uint32_t bits = (uint32_t)(word >> 32);
+            std::memcpy(&time, &bits, 4);
+            result.pocketed.push_back(PocketedBall{ (int)(word & 0xFF), (int)((word >> 8) & 0xFF), time });
+        }
+
+        // Only write the bit when it changes, so hot entries don't bounce the cache line
+        if (slot.referenced.load(std::memory_order_relaxed) == 0) {
+            slot.referenced.store(1, std::memory_order_relaxed);
+        }
+        hits.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    misses.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+ShotCache::Slot* ShotCache::chooseVictim(Bucket& bucket, uint64_t key) {
+    for (Slot& slot : bucket.slots) {
+        if (slot.key.load(std::memory_order_relaxed) == key) return &slot;
+    }
+    for (Slot& slot : bucket.slots) {
+        if (slot.key.load(std::memory_order_relaxed) == 0) return &slot;
+    }
+
+    // CLOCK: clear reference bits under the hand until an unreferenced entry comes up
+    for (int sweep = 0; sweep < 2 * WAYS; ++sweep) {
+        uint32_t way = bucket.hand.fetch_add(1, std::memory_order_relaxed) % WAYS;
+        Slot& slot = bucket.slots[way];
+        if (slot.referenced.exchange(0, std::memory_order_relaxed) == 0) {
+            evictions.fetch_add(1, std::memory_order_relaxed);
+            return &slot;
+        }
+    }
+    evictions.fetch_add(1, std::memory_order_relaxed);
+    return &bucket.slots[bucket.hand.load(std::memory_order_relaxed) % WAYS];
+}
+
+void ShotCache::store(uint64_t key, const BallSystem& balls, const Physics::ShotResult& result) {
+    if (balls.size() > (size_t)MAX_BALLS || result.pocketed.size() > (size_t)MAX_BALLS) return;
+
+    Slot& slot = *chooseVictim(bucketFor(key), key);
+
+    // Another writer owns the slot: this is only a cache, so drop the entry
+    uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    if (sequence & 1) return;
+    if (!slot.sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_acq_rel)) return;
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint32_t activeMask = 0;
+    for (size_t i = 0; i < balls.size(); ++i) {
+        if (balls.active[i]) activeMask |= 1u << i;
+        slot.words[HEADER_WORDS + i].store(packPair(toFloat(balls.x[i]), toFloat(balls.y[i])), std::memory_order_relaxed);
+    }
+    for (size_t p = 0; p < result.pocketed.size(); ++p) {
+        const PocketedBall& pocketed = result.pocketed[p];
+        float time = (float)pocketed.time;
+        uint32_t bits;
+        std::memcpy(&bits, &time, 4);
+        uint64_t word = (uint64_t)(pocketed.ball & 0xFF) | ((uint64_t)(pocketed.pocket & 0xFF) << 8) | ((uint64_t)bits << 32);
+        slot.words[HEADER_WORDS + MAX_BALLS + p].store(word, std::memory_order_relaxed);
+    }
+
+    uint64_t header = (uint64_t)balls.size() | ((uint64_t)result.pocketed.size() << 8) |
+        ((uint64_t)(result.settled ? 1 : 0) << 16) | ((uint64_t)activeMask << 32);
+    uint64_t duration;
+    std::memcpy(&duration, &result.duration, sizeof(double));
+    slot.words[0].store(header, std::memory_order_relaxed);
+    slot.words[1].store(duration, std::memory_order_relaxed);
+    slot.words[2].store((uint64_t)result.events, std::memory_order_relaxed);
+    slot.key.store(key, std::memory_order_relaxed);
+    slot.referenced.store(0, std::memory_order_relaxed);
+
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+Physics::ShotResult ShotCache::simulate(BallSystem& balls, const Table& table, const Physics::Shot& shot,
+    EventSimulator& simulator, double maxTime) {
+    Physics::ShotResult result;
+    uint64_t key = makeKey(balls, shot);
+    if (lookup(key, balls, result)) return result;
+
+    Physics::applyShot(balls, shot);
+    result = Physics::simulateToRest(balls, table, simulator, maxTime);
+    store(key, balls, result);
+    return result;
+}
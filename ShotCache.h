@@ -0,0 +1,85 @@
+#ifndef SHOT_CACHE_H
+#define SHOT_CACHE_H
+
+#include "Physics.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Kes ishoda udarca: kljuc je hes kvantizovanih pozicija kugli, maske aktivnih
+// i kvantizovanog ugla i jacine, a vrednost konacne pozicije kugli i upale kugle.
+// Dva stanja koja se razlikuju manje od koraka kvantizacije dele ishod, pa se
+// korak bira kao kompromis izmedju broja pogodaka i tacnosti.
+//
+// Memorija je fiksna: WAYS-struki asocijativni skupovi, u svakom skupu CLOCK
+// izbacivanje (pogodak postavlja bit, kazaljka skupa trazi ulaz bez bita).
+// Citanje je bez zakljucavanja (seqlock po ulazu - citalac ponavlja ako je ulaz
+// upravo prepisan), a upis koji zatekne zauzet ulaz se preskace.
+// Jedan kes vazi za jedan sto i jedan raspored kugli (radijusi se ne hesiraju).
+class ShotCache {
+public:
+    static const int MAX_BALLS = 16;
+    static const int WAYS = 4;
+
+    // capacity = broj ulaza (zaokruzuje se na stepen dvojke)
+    explicit ShotCache(size_t capacity, float positionStep = 0.001f,
+        float angleStep = 0.0005f, float speedStep = 0.005f);
+
+    ShotCache(const ShotCache&) = delete;
+    ShotCache& operator=(const ShotCache&) = delete;
+
+    // Kljuc za stanje pre udarca i udarac (nikad 0)
+    uint64_t makeKey(const BallSystem& balls, const Physics::Shot& shot) const;
+
+    // Na pogodak upisuje konacno stanje u balls (kugle miruju i budne su, kao posle
+    // simulateToRest) i ishod u result. balls mora imati isti raspored kao pri upisu.
+    bool lookup(uint64_t key, BallSystem& balls, Physics::ShotResult& result);
+
+    // Pamti konacno stanje; preskace se za vise od MAX_BALLS kugli
+    void store(uint64_t key, const BallSystem& balls, const Physics::ShotResult& result);
+
+    // Zadaje udarac i vraca ishod iz kesa, a na promasaj simulira i pamti
+    Physics::ShotResult simulate(BallSystem& balls, const Table& table, const Physics::Shot& shot,
+        EventSimulator& simulator, double maxTime = 120.0);
+
+    uint64_t getHits() const { return hits.load(std::memory_order_relaxed); }
+    uint64_t getMisses() const { return misses.load(std::memory_order_relaxed); }
+    uint64_t getEvictions() const { return evictions.load(std::memory_order_relaxed); }
+    void resetCounters();
+
+    size_t getCapacity() const { return bucketCount * WAYS; }
+    size_t bytes() const { return bucketCount * sizeof(Bucket); }
+
+private:
+    // Zaglavlje, trajanje, broj dogadjaja, pozicije (x, y kao dva float-a) i upale kugle, po 64 bita
+    static const int HEADER_WORDS = 3;
+    static const int PAYLOAD_WORDS = HEADER_WORDS + 2 * MAX_BALLS;
+
+    struct Slot {
+        std::atomic<uint32_t> sequence;  // neparan dok se ulaz prepisuje
+        std::atomic<uint32_t> referenced;
+        std::atomic<uint64_t> key;       // 0 = prazan
+        std::atomic<uint64_t> words[PAYLOAD_WORDS];
+    };
+
+    struct Bucket {
+        Slot slots[WAYS];
+        std::atomic<uint32_t> hand;
+    };
+
+    Bucket& bucketFor(uint64_t key) const { return buckets[key & (bucketCount - 1)]; }
+    bool read(Slot& slot, uint64_t key, uint64_t* words) const;
+    Slot* chooseVictim(Bucket& bucket, uint64_t key);
+
+    std::unique_ptr<Bucket[]> buckets;
+    size_t bucketCount;
+
+    float positionStep, angleStep, speedStep;
+
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+    std::atomic<uint64_t> evictions;
+};
+
+#endif
@@ -0,0 +1,164 @@
+#include "ShotEvaluator.h"
+#include <chrono>
+#include <cmath>
+
+ShotEvaluator::ShotEvaluator(JobSystem& jobs)
+    : jobs(&jobs), requested(0), sampleCount(256), angleSigma(0.01f), powerSigma(0.05f),
+    seed(0x5EEDULL), maxTime(30.0), generation(0),
+    samplesDone(0), scratchTotal(0), cueCount(0) {
+    aim = Physics::Shot{ 0, 0.0f, 0.0f };
+    scratch.resize(jobs.getWorkerCount());
+}
+
+ShotEvaluator::~ShotEvaluator() {
+    cancel();
+}
+
+void ShotEvaluator::start(const BallSystem& balls, const Table& table, const Physics::Shot& shot) {
+    cancel();
+
+    initial = balls;
+    this->table = table;
+    aim = shot;
+    unsigned current = ++generation;
+
+    {
+        std::lock_guard<std::mutex> lock(totalsMutex);
+        requested = sampleCount;
+        samplesDone = 0;
+        pocketTotals.assign(balls.size(), 0);
+        scratchTotal = 0;
+        batchSumX.assign((requested + SAMPLE_BATCH - 1) / SAMPLE_BATCH, 0.0);
+        batchSumY.assign(batchSumX.size(), 0.0);
+        cueCount = 0;
+    }
+
+    for (int begin = 0; begin < requested; begin += SAMPLE_BATCH) {
+        int end = begin + SAMPLE_BATCH < requested ? begin + SAMPLE_BATCH : requested;
+        jobs->submit(group, [this, current, begin, end](int worker) {
+            runBatch(worker, current, begin, end);
+        });
+    }
+}
+
+void ShotEvaluator::update(double seconds) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+    while (!group.isDone() && std::chrono::steady_clock::now() < deadline) {
+        if (!jobs->help()) break;
+    }
+}
+
+void ShotEvaluator::finish() {
+    jobs->wait(group);
+}
+
+void ShotEvaluator::cancel() {
+    // Queued batches of the old generation return without simulating
+    ++generation;
+    jobs->wait(group);
+}
+
+// SplitMix64 - a stateless mix of seed and sample index, so each sample's
+// perturbation does not depend on which worker runs it or in what order
+static uint64_t nextRandom(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static double uniform(uint64_t& state) {
+    // 53 random bits in (0, 1]
+    return ((nextRandom(state) >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+static float gaussian(uint64_t& state) {
+    // Box-Muller
+    double u1 = uniform(state);
+    double u2 = uniform(state);
+    return (float)(std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2));
+}
+
+Physics::Shot ShotEvaluator::sampleShot(int k) const {
+    uint64_t state = seed ^ ((uint64_t)k * 0xD1B54A32D192ED03ULL);
+    Physics::Shot shot = aim;
+    shot.angle += angleSigma * gaussian(state);
+    shot.speed *= 1.0f + powerSigma * gaussian(state);
+    if (shot.speed < 0.0f) shot.speed = 0.0f;
+    return shot;
+}
+
+void ShotEvaluator::runBatch(int worker, unsigned batchGeneration, int begin, int end) {
+    WorkerScratch& local = scratch[worker];
+    if (local.generation != batchGeneration) {
+        if (local.snapshot.getCapacity() < initial.size()) local.snapshot = Snapshot(initial.size());
+        local.balls = initial;
+        local.snapshot.capture(local.balls);
+        local.generation = batchGeneration;
+    }
+
+    const int cue = aim.ball;
+    local.pocketCounts.assign(initial.size(), 0);
+    int samples = 0;
+    int scratches = 0;
+    double sumX = 0.0, sumY = 0.0;
+    int cueSamples = 0;
+
+    for (int k = begin; k < end; ++k) {
+        if (generation.load(std::memory_order_relaxed) != batchGeneration) return;
+
+        local.snapshot.restore(local.balls);
+        Physics::applyShot(local.balls, sampleShot(k));
+        local.events.run(local.balls, table, maxTime);
+
+        for (const PocketedBall& pocketed : local.events.getPocketed()) {
+            ++local.pocketCounts[pocketed.ball];
+        }
+        if (local.balls.active[cue]) {
+            sumX += toFloat(local.balls.x[cue]);
+            sumY += toFloat(local.balls.y[cue]);
+            ++cueSamples;
+        }
+        else {
+            ++scratches;
+        }
+        ++samples;
+    }
+
+    std::lock_guard<std::mutex> lock(totalsMutex);
+    if (generation.load(std::memory_order_relaxed) != batchGeneration) return;
+    for (size_t i = 0; i < pocketTotals.size(); ++i) {
+        pocketTotals[i] += local.pocketCounts[i];
+    }
+    samplesDone += samples;
+    scratchTotal += scratches;
+    batchSumX[begin / SAMPLE_BATCH] = sumX;
+    batchSumY[begin / SAMPLE_BATCH] = sumY;
+    cueCount += cueSamples;
+}
+
+ShotEstimate ShotEvaluator::getEstimate() const {
+    std::lock_guard<std::mutex> lock(totalsMutex);
+
+    ShotEstimate estimate;
+    estimate.samples = samplesDone;
+    estimate.requested = requested;
+    estimate.pocketProbability.resize(pocketTotals.size(), 0.0f);
+    if (samplesDone > 0) {
+        for (size_t i = 0; i < pocketTotals.size(); ++i) {
+            estimate.pocketProbability[i] = (float)pocketTotals[i] / samplesDone;
+        }
+        estimate.scratchProbability = (float)scratchTotal / samplesDone;
+    }
+    if (cueCount > 0) {
+        // Batches still running hold 0.0, which leaves the sum exact
+        double sumX = 0.0, sumY = 0.0;
+        for (size_t batch = 0; batch < batchSumX.size(); ++batch) {
+            sumX += batchSumX[batch];
+            sumY += batchSumY[batch];
+        }
+        estimate.cueX = (float)(sumX / cueCount);
+        estimate.cueY = (float)(sumY / cueCount);
+    }
+    return estimate;
+}
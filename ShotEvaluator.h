@@ -0,0 +1,110 @@
+#ifndef SHOT_EVALUATOR_H
+#define SHOT_EVALUATOR_H
+
+#include "Physics.h"
+#include "JobSystem.h"
+#include "Snapshot.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Trenutna procena ishoda udarca; popunjava se kako uzorci stizu
+struct ShotEstimate {
+    int samples;                           // zavrsenih uzoraka
+    int requested;                         // ukupno zadatih
+    std::vector<float> pocketProbability;  // za svaku kuglu, verovatnoca da upadne
+    float scratchProbability;              // verovatnoca da upadne bela (kugla iz udarca)
+    float cueX, cueY;                      // prosecna konacna pozicija bele kad ne upadne
+
+    ShotEstimate() : samples(0), requested(0), scratchProbability(0.0f), cueX(0.0f), cueY(0.0f) {}
+
+    bool isComplete() const { return samples >= requested; }
+};
+
+// Monte-Carlo procena udarca: K uzoraka sa nasumicno pomerenim uglom i jacinom
+// (Gausova raspodela) simulira se do mirovanja preko JobSystem-a. Uzorci idu u
+// grupama od SAMPLE_BATCH, a zbir se azurira posle svake grupe, pa getEstimate
+// vraca procenu koja se popravlja dok se racuna - UI je moze crtati svaki frejm.
+//
+// Uzorak k uvek dobija isti pomeraj (seme + k), pa je konacni rezultat isti bez
+// obzira na broj radnika. Svaki radnik ima svoju kopiju stola i Snapshot, pa se
+// izmedju uzoraka vracaju samo kugle koje su se pomerile.
+class ShotEvaluator {
+public:
+    static const int SAMPLE_BATCH = 8;
+
+    explicit ShotEvaluator(JobSystem& jobs);
+    ~ShotEvaluator();
+
+    ShotEvaluator(const ShotEvaluator&) = delete;
+    ShotEvaluator& operator=(const ShotEvaluator&) = delete;
+
+    void setSampleCount(int count) { sampleCount = count; }
+    void setAngleSigma(float radians) { angleSigma = radians; }
+    void setPowerSigma(float fraction) { powerSigma = fraction; }  // relativno, 0.05 = 5%
+    void setSeed(uint64_t value) { seed = value; }
+    void setMaxTime(double seconds) { maxTime = seconds; }
+
+    // Prekida prethodnu procenu i pocinje novu za udarac shot (ugao i jacina kao u
+    // mouseButtonCallback). Stanje stola se kopira, pa balls i table mogu da se menjaju.
+    void start(const BallSystem& balls, const Table& table, const Physics::Shot& shot);
+
+    // Pozivajuca nit pomaze oko uzoraka najvise seconds sekundi (za jednu nit ili
+    // da procena brze stigne u okviru frejma); radnici rade i bez ovoga
+    void update(double seconds);
+
+    // Ceka sve uzorke
+    void finish();
+
+    // Odbacuje preostale uzorke
+    void cancel();
+
+    bool isDone() const { return group.isDone(); }
+
+    ShotEstimate getEstimate() const;
+
+private:
+    struct WorkerScratch {
+        BallSystem balls;
+        Snapshot snapshot;
+        EventSimulator events;
+        unsigned generation;
+        std::vector<int> pocketCounts;
+
+        WorkerScratch() : snapshot(0), generation(0) {}
+    };
+
+    void runBatch(int worker, unsigned generation, int begin, int end);
+    Physics::Shot sampleShot(int k) const;
+
+    JobSystem* jobs;
+    JobGroup group;
+    std::vector<WorkerScratch> scratch;
+
+    // Zadatak tekuce procene (menja se samo u start, kad nijedan posao ne radi)
+    BallSystem initial;
+    Table table;
+    Physics::Shot aim;
+    int requested;
+
+    int sampleCount;
+    float angleSigma;
+    float powerSigma;
+    uint64_t seed;
+    double maxTime;
+
+    // Svaki start povecava generaciju; posao stare generacije odmah izlazi
+    std::atomic<unsigned> generation;
+
+    mutable std::mutex totalsMutex;
+    int samplesDone;
+    std::vector<int> pocketTotals;
+    int scratchTotal;
+    // Zbir pozicija bele po grupi uzoraka (indeks begin / SAMPLE_BATCH); getEstimate
+    // ih sabira redom grupa, pa prosek ne zavisi od redosleda zavrsavanja grupa
+    std::vector<double> batchSumX, batchSumY;
+    int cueCount;
+};
+
+#endif
@@ -0,0 +1,73 @@
+#include "Simd.h"
+
+#if defined(SIMD_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Simd {
+
+#if defined(SIMD_X86) && defined(_MSC_VER)
+    static bool detectSSE2() {
+        int info[4];
+        __cpuid(info, 1);
+        return (info[3] & (1 << 26)) != 0;
+    }
+
+    static bool detectAVX2() {
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+
+        // The OS has to save the YMM registers (OSXSAVE + XCR0 bits 1 and 2)
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx) return false;
+        if ((_xgetbv(0) & 0x6) != 0x6) return false;
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    }
+#elif defined(SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+    static bool detectSSE2() {
+        return __builtin_cpu_supports("sse2");
+    }
+
+    static bool detectAVX2() {
+        return __builtin_cpu_supports("avx2");
+    }
+#else
+    static bool detectSSE2() {
+        return false;
+    }
+
+    static bool detectAVX2() {
+        return false;
+    }
+#endif
+
+    bool hasSSE2() {
+        static const bool supported = detectSSE2();
+        return supported;
+    }
+
+    bool hasAVX2() {
+        static const bool supported = detectAVX2();
+        return supported;
+    }
+
+    Path bestPath() {
+        if (hasAVX2()) return Path::AVX2;
+        if (hasSSE2()) return Path::SSE2;
+        return Path::Scalar;
+    }
+
+    const char* pathName(Path path) {
+        switch (path) {
+        case Path::AVX2: return "AVX2";
+        case Path::SSE2: return "SSE2";
+        default: return "Scalar";
+        }
+    }
+
+}
@@ -0,0 +1,36 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+// Podrska za SIMD putanje sa izborom u toku izvrsavanja.
+// Funkcije sa SSE/AVX2 intrinsic-ima se oznacavaju sa SIMD_TARGET_*,
+// tako da GCC/Clang mogu da ih prevedu bez globalnog -mavx2 (MSVC to ne trazi).
+
+// SIMD putanje rade nad float nizovima, pa se u rezimu sa fiksnom tackom (Real.h) ne prevode
+#if (defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)) && !defined(PHYSICS_FIXED_POINT)
+#define SIMD_X86 1
+#endif
+
+#if defined(SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define SIMD_TARGET_SSE2 __attribute__((target("sse2")))
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SIMD_TARGET_SSE2
+#define SIMD_TARGET_AVX2
+#endif
+
+namespace Simd {
+    // Najbolja putanja koju procesor podrzava
+    enum class Path {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    bool hasSSE2();
+    bool hasAVX2();
+
+    Path bestPath();
+    const char* pathName(Path path);
+}
+
+#endif
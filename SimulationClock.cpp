@@ -0,0 +1,29 @@
+#include "SimulationClock.h"
+
+SimulationClock::SimulationClock(float stepRate)
+    : stepRate(stepRate), stepDt(1.0f / stepRate), maxFrameTime(0.1f), accumulator(0.0f),
+    frameSteps(0), frameSubsteps(0) {}
+
+void SimulationClock::setStepRate(float stepRate) {
+    // Keep the same fraction of a step pending so interpolation doesn't jump
+    float alpha = getAlpha();
+    this->stepRate = stepRate;
+    stepDt = 1.0f / stepRate;
+    accumulator = alpha * stepDt;
+}
+
+int SimulationClock::advance(float frameTime) {
+    if (frameTime < 0.0f) frameTime = 0.0f;
+    if (frameTime > maxFrameTime) frameTime = maxFrameTime;
+
+    accumulator += frameTime;
+
+    int steps = 0;
+    while (accumulator >= stepDt) {
+        accumulator -= stepDt;
+        steps++;
+    }
+    frameSteps = steps;
+    frameSubsteps = 0;
+    return steps;
+}
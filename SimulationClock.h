@@ -0,0 +1,42 @@
+#ifndef SIMULATION_CLOCK_H
+#define SIMULATION_CLOCK_H
+
+// Fiksni korak simulacije: vreme frejma se skuplja u akumulator i trosi
+// u koracima od 1/stepRate sekundi, nezavisno od brzine crtanja.
+// Ostatak akumulatora (alpha) sluzi za interpolaciju pozicija pri crtanju.
+class SimulationClock {
+public:
+    explicit SimulationClock(float stepRate = 240.0f);
+
+    // Frekvencija fizike (npr. 240 ili 1000 Hz)
+    void setStepRate(float stepRate);
+    float getStepRate() const { return stepRate; }
+    float getStepDt() const { return stepDt; }
+
+    // Najduzi frejm koji se nadoknadjuje - posle zastoja simulacija radije uspori nego da zaglavi
+    void setMaxFrameTime(float seconds) { maxFrameTime = seconds; }
+
+    // Dodaje vreme frejma i vraca koliko fizickih koraka treba izvrsiti
+    int advance(float frameTime);
+
+    // Koliko je akumulator odmakao ka sledecem koraku (0-1)
+    float getAlpha() const { return accumulator / stepDt; }
+
+    void reset() { accumulator = 0.0f; }
+
+    // Za profilisanje: koraci iz poslednjeg advance i podkoraci koje su oni napravili
+    // (Physics::updatePhysicsAdaptive), prijavljeni preko addSubsteps
+    void addSubsteps(int substeps) { frameSubsteps += substeps; }
+    int getFrameSteps() const { return frameSteps; }
+    int getFrameSubsteps() const { return frameSubsteps; }
+
+private:
+    float stepRate;
+    float stepDt;
+    float maxFrameTime;
+    float accumulator;
+    int frameSteps;
+    int frameSubsteps;
+};
+
+#endif
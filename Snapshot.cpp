@@ -0,0 +1,108 @@
+#include "Snapshot.h"
+#include <stdexcept>
+
+Snapshot::Snapshot(size_t capacity)
+    : capacity(capacity), count(0), source(nullptr), generation(0) {
+    x.resize(capacity);
+    y.resize(capacity);
+    vx.resize(capacity);
+    vy.resize(capacity);
+    prevX.resize(capacity);
+    prevY.resize(capacity);
+    active.resize(capacity);
+    asleep.resize(capacity);
+    restSteps.resize(capacity);
+    islandParent.resize(capacity);
+    islandNext.resize(capacity);
+    awake.reserve(capacity);
+}
+
+template <typename T>
+static void copyArray(AlignedArray<T>& to, const AlignedArray<T>& from, size_t n) {
+    if (n > 0) std::memcpy(to.data(), from.data(), n * sizeof(T));
+}
+
+void Snapshot::checkSize(const BallSystem& balls) const {
+    if (balls.size() != count) throw std::invalid_argument("Snapshot: ball count differs from the captured system");
+}
+
+void Snapshot::track(BallSystem& balls) {
+    balls.beginTracking();
+    source = &balls;
+    generation = balls.getTrackingGeneration();
+}
+
+void Snapshot::capture(BallSystem& balls) {
+    if (balls.size() > capacity) throw std::length_error("Snapshot: more balls than capacity");
+    count = balls.size();
+
+    copyArray(x, balls.x, count);
+    copyArray(y, balls.y, count);
+    copyArray(vx, balls.vx, count);
+    copyArray(vy, balls.vy, count);
+    copyArray(prevX, balls.prevX, count);
+    copyArray(prevY, balls.prevY, count);
+    copyArray(active, balls.active, count);
+    copyArray(asleep, balls.asleep, count);
+    copyArray(restSteps, balls.restSteps, count);
+    copyArray(islandParent, balls.islandParent, count);
+    copyArray(islandNext, balls.islandNext, count);
+    const std::vector<int>& awakeNow = balls.awakeBalls();
+    awake.assign(awakeNow.begin(), awakeNow.end());
+
+    track(balls);
+}
+
+size_t Snapshot::restore(BallSystem& balls) {
+    // Somebody else restarted tracking, so the change list no longer covers everything since capture
+    if (source != &balls || generation != balls.getTrackingGeneration()) {
+        restoreAll(balls);
+        return count;
+    }
+    checkSize(balls);
+
+    const std::vector<int>& changed = balls.changedBalls();
+    for (int i : changed) {
+        balls.x[i] = x[i];
+        balls.y[i] = y[i];
+        balls.vx[i] = vx[i];
+        balls.vy[i] = vy[i];
+        balls.prevX[i] = prevX[i];
+        balls.prevY[i] = prevY[i];
+        balls.active[i] = active[i];
+        balls.asleep[i] = asleep[i];
+        balls.restSteps[i] = restSteps[i];
+        balls.islandParent[i] = islandParent[i];
+        balls.islandNext[i] = islandNext[i];
+    }
+    size_t restored = changed.size();
+
+    restoreAwakeList(balls);
+    track(balls);
+    return restored;
+}
+
+void Snapshot::restoreAwakeList(BallSystem& balls) const {
+    // Copying into the existing list keeps its capacity, so this allocates at most once
+    balls.awakeList.assign(awake.begin(), awake.end());
+    balls.awakeListDirty = false;
+}
+
+void Snapshot::restoreAll(BallSystem& balls) {
+    checkSize(balls);
+
+    copyArray(balls.x, x, count);
+    copyArray(balls.y, y, count);
+    copyArray(balls.vx, vx, count);
+    copyArray(balls.vy, vy, count);
+    copyArray(balls.prevX, prevX, count);
+    copyArray(balls.prevY, prevY, count);
+    copyArray(balls.active, active, count);
+    copyArray(balls.asleep, asleep, count);
+    copyArray(balls.restSteps, restSteps, count);
+    copyArray(balls.islandParent, islandParent, count);
+    copyArray(balls.islandNext, islandNext, count);
+
+    restoreAwakeList(balls);
+    track(balls);
+}
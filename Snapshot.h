@@ -0,0 +1,50 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "BallSystem.h"
+#include <cstddef>
+#include <vector>
+
+// Kopija promenljivog stanja BallSystem-a u unapred zauzetim nizovima, za
+// pretragu i Monte-Carlo: capture, simulacija, restore, pa opet ispocetka.
+// Posle konstrukcije ni capture ni restore ne zauzimaju memoriju.
+//
+// Cuvaju se pozicije, brzine, aktivnost i spavanje; radijus, boja i isWhite se
+// tokom simulacije ne menjaju, a sto je nepromenljiv i deli se po referenci.
+// restore vraca samo kugle koje BallSystem oznaci kao promenjene od capture
+// (ili od prethodnog restore), pa kad se pomeri nekoliko kugli restore kosta
+// samo toliko kugli. Za drugi sistem ili posle novog pracenja vraca sve.
+class Snapshot {
+public:
+    explicit Snapshot(size_t capacity);
+
+    // Kopira stanje i pocinje pracenje promena u balls
+    void capture(BallSystem& balls);
+
+    // Vraca stanje iz capture; vraca broj kugli koje su prepisane
+    size_t restore(BallSystem& balls);
+
+    // Uvek prepisuje sve kugle
+    void restoreAll(BallSystem& balls);
+
+    size_t size() const { return count; }
+    size_t getCapacity() const { return capacity; }
+
+private:
+    void checkSize(const BallSystem& balls) const;
+    void track(BallSystem& balls);
+    void restoreAwakeList(BallSystem& balls) const;
+
+    size_t capacity;
+    size_t count;
+
+    const BallSystem* source;
+    unsigned generation;
+
+    AlignedArray<Real> x, y, vx, vy, prevX, prevY;
+    AlignedArray<bool> active, asleep;
+    AlignedArray<int> restSteps, islandParent, islandNext;
+    std::vector<int> awake;    // awakeBalls() pri capture, da se lista ne gradi ponovo
+};
+
+#endif
@@ -3,19 +3,34 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <memory>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
 #include "../Ball.h"
+#include "../BallSystem.h"
 #include "../Table.h"
 #include "../Physics.h"
+#include "../SimulationClock.h"
+#include "../BreakDatabase.h"
+#include "../BallInHand.h"
+#include "../Calibrator.h"
+#include "../Benchmark.h"
 #include "../Header/Util.h"
 
 const int SCREEN_WIDTH = 1600;
 const int SCREEN_HEIGHT = 900;
 const int NUM_CIRCLE_SEGMENTS = 40;
 
+// Physics runs at a fixed rate, rendering is capped separately
+const float PHYSICS_STEP_RATE = 240.0f;
+const double RENDER_FRAME_RATE = 75.0;
+
 // Shot power settings
 const float CHARGE_DURATION = 2.0f;
 const float MIN_POWER = 0.6f;
@@ -23,7 +38,8 @@ const float MAX_POWER = 7.2f;
 
 // Global input variables
 double mouseX = 0.0, mouseY = 0.0;
-Ball* whiteBall = nullptr;
+BallSystem* gameBalls = nullptr;
+int whiteBallIndex = -1;
 int currentScreenWidth = SCREEN_WIDTH;
 int currentScreenHeight = SCREEN_HEIGHT;
 
@@ -31,9 +47,20 @@ int currentScreenHeight = SCREEN_HEIGHT;
 bool isCharging = false;
 double chargeStartTime = 0.0;
 
-// White ball respawn position
-float whiteBallStartX = -0.4f;
-float whiteBallStartY = 0.0f;
+// Space skips the animation of the current shot
+bool skipShotRequested = false;
+
+// P toggles the physics step counts for the last frame
+bool showStepStats = false;
+
+// Precomputed break outcomes, shown while aiming the first shot
+const char* BREAK_DATABASE_PATH = "breaks.db";
+const char* TABLE_PARAMS_PATH = "table.params";
+bool breakShotTaken = false;
+
+// After a scratch the player places the cue ball anywhere legal, guided by a heatmap
+bool ballInHand = false;
+bool placeCueRequested = false;
 
 // FreeType text rendering structures
 struct Character {
@@ -60,11 +87,22 @@ void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
         glfwSetWindowShouldClose(window, GLFW_TRUE);
     }
+    if (key == GLFW_KEY_SPACE && action == GLFW_PRESS) {
+        skipShotRequested = true;
+    }
+    if (key == GLFW_KEY_P && action == GLFW_PRESS) {
+        showStepStats = !showStepStats;
+    }
 }
 
 void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
-    if (button == GLFW_MOUSE_BUTTON_LEFT && whiteBall) {
-        if (whiteBall->isStopped() && whiteBall->active) {
+    if (button == GLFW_MOUSE_BUTTON_LEFT && gameBalls && whiteBallIndex >= 0) {
+        if (ballInHand) {
+            if (action == GLFW_PRESS) placeCueRequested = true;
+            return;
+        }
+        BallRef whiteBall = (*gameBalls)[whiteBallIndex];
+        if (whiteBall.isStopped() && whiteBall.active) {
             if (action == GLFW_PRESS) {
                 isCharging = true;
                 chargeStartTime = glfwGetTime();
@@ -76,14 +114,16 @@ void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
                 float power = MIN_POWER + (MAX_POWER - MIN_POWER) * (chargeTime / CHARGE_DURATION);
                 float worldX, worldY;
                 screenToWorld(mouseX, mouseY, worldX, worldY);
-                float dx = worldX - whiteBall->x;
-                float dy = worldY - whiteBall->y;
+                float dx = worldX - toFloat(whiteBall.x);
+                float dy = worldY - toFloat(whiteBall.y);
                 float dist = length(dx, dy);
                 if (dist > 0.01f) {
                     dx /= dist;
                     dy /= dist;
-                    whiteBall->vx = dx * power;
-                    whiteBall->vy = dy * power;
+                    whiteBall.vx = dx * power;
+                    whiteBall.vy = dy * power;
+                    gameBalls->wake(whiteBallIndex);
+                    breakShotTaken = true;
                 }
             }
         }
@@ -95,20 +135,21 @@ void mousePosCallback(GLFWwindow* window, double xpos, double ypos) {
     mouseY = ypos;
 }
 
-void setupBalls(std::vector<Ball>& balls) {
+void setupBalls(BallSystem& balls) {
     balls.clear();
     float ballRadius = 0.025f;
-    balls.push_back(Ball(-0.4f, 0.0f, ballRadius, 1.0f, 1.0f, 1.0f, true));
+    balls.add(Ball(-0.4f, 0.0f, ballRadius, 1.0f, 1.0f, 1.0f, true));
     float startX = 0.3f;
     float startY = 0.0f;
     float spacing = ballRadius * 2.2f;
-    balls.push_back(Ball(startX, startY, ballRadius, 1.0f, 0.0f, 0.0f));
-    balls.push_back(Ball(startX + spacing, startY + spacing * 0.866f, ballRadius, 1.0f, 1.0f, 0.0f));
-    balls.push_back(Ball(startX + spacing, startY - spacing * 0.866f, ballRadius, 0.0f, 0.0f, 1.0f));
-    balls.push_back(Ball(startX + spacing * 2, startY, ballRadius, 1.0f, 0.5f, 0.0f));
-    balls.push_back(Ball(startX + spacing * 2, startY + spacing * 1.732f, ballRadius, 0.5f, 0.0f, 0.5f));
-    balls.push_back(Ball(startX + spacing * 2, startY - spacing * 1.732f, ballRadius, 0.0f, 1.0f, 1.0f));
-    whiteBall = &balls[0];
+    balls.add(Ball(startX, startY, ballRadius, 1.0f, 0.0f, 0.0f));
+    balls.add(Ball(startX + spacing, startY + spacing * 0.866f, ballRadius, 1.0f, 1.0f, 0.0f));
+    balls.add(Ball(startX + spacing, startY - spacing * 0.866f, ballRadius, 0.0f, 0.0f, 1.0f));
+    balls.add(Ball(startX + spacing * 2, startY, ballRadius, 1.0f, 0.5f, 0.0f));
+    balls.add(Ball(startX + spacing * 2, startY + spacing * 1.732f, ballRadius, 0.5f, 0.0f, 0.5f));
+    balls.add(Ball(startX + spacing * 2, startY - spacing * 1.732f, ballRadius, 0.0f, 1.0f, 1.0f));
+    gameBalls = &balls;
+    whiteBallIndex = 0;
 }
 
 bool initFreeType() {
@@ -187,10 +228,12 @@ void renderText(const std::string& text, float x, float y, float scale, float r,
     glBindTexture(GL_TEXTURE_2D, 0);
 }
 
-void drawAimLine(unsigned int lineShader, unsigned int lineVAO, const Ball& ball, float mouseWorldX, float mouseWorldY) {
+void drawAimLine(unsigned int lineShader, unsigned int lineVAO, const BallRef& ball, float mouseWorldX, float mouseWorldY) {
     if (!ball.active || !ball.isStopped()) return;
-    float dx = mouseWorldX - ball.x;
-    float dy = mouseWorldY - ball.y;
+    float ballX = toFloat(ball.x);
+    float ballY = toFloat(ball.y);
+    float dx = mouseWorldX - ballX;
+    float dy = mouseWorldY - ballY;
     float dist = length(dx, dy);
     if (dist < 0.01f) return;
     dx /= dist;
@@ -207,10 +250,10 @@ void drawAimLine(unsigned int lineShader, unsigned int lineVAO, const Ball& ball
             segmentLength = maxLength - currentLength;
         }
         if (isDash && segmentLength > 0) {
-            float x1 = ball.x + dx * currentLength;
-            float y1 = ball.y + dy * currentLength;
-            float x2 = ball.x + dx * (currentLength + segmentLength);
-            float y2 = ball.y + dy * (currentLength + segmentLength);
+            float x1 = ballX + dx * currentLength;
+            float y1 = ballY + dy * currentLength;
+            float x2 = ballX + dx * (currentLength + segmentLength);
+            float y2 = ballY + dy * (currentLength + segmentLength);
             lineVertices.push_back(x1);
             lineVertices.push_back(y1);
             lineVertices.push_back(x2);
@@ -264,14 +307,103 @@ void drawPowerBar(unsigned int shader, float powerPercent) {
     glDeleteVertexArrays(1, &barVAO);
 }
 
-bool checkGameOver(const std::vector<Ball>& balls) {
-    for (const auto& ball : balls) {
-        if (!ball.isWhite && ball.active) return false;
+// Friction and damping come from table.params when it exists, so a calibrated table needs no rebuild
+Table createTable() {
+    Table table(-1.5f, 1.5f, 0.8f, -0.8f);
+    table.physics.load(TABLE_PARAMS_PATH);
+    return table;
+}
+
+// Simulates every break on the default grid and writes the database; runs without a window
+int buildBreakDatabase(const char* path) {
+    BallSystem balls;
+    setupBalls(balls);
+    Table table = createTable();
+    BatchSimulator batch;
+    BreakGrid grid;
+
+    std::cout << "Simulating " << grid.cellCount() << " breaks on " << batch.getWorkerCount() << " threads..." << std::endl;
+    if (!BreakDatabase::build(path, balls, whiteBallIndex, table, grid, batch)) {
+        std::cerr << "Failed to write break database " << path << std::endl;
+        return -1;
+    }
+    std::cout << "Break database written to " << path << std::endl;
+    return 0;
+}
+
+// Fits friction and damping to recorded trajectories and writes them as the table parameters
+int calibrateTable(const char* trajectoryPath, const char* paramsPath) {
+    std::vector<ReferenceTrajectory> trajectories;
+    if (!loadTrajectories(trajectoryPath, trajectories)) {
+        std::cerr << "Failed to read trajectories from " << trajectoryPath << std::endl;
+        return -1;
+    }
+
+    Table table = createTable();
+    JobSystem jobs;
+    Calibrator calibrator(jobs);
+    calibrator.setTrajectories(trajectories);
+
+    double startError = calibrator.error(table, table.physics);
+    PhysicsParams fitted = calibrator.fit(table);
+    std::printf("Friction %.5f -> %.5f, damping %.4f -> %.4f, error %.3g -> %.3g (%d simulations per trajectory)\n",
+        table.physics.friction, fitted.friction, table.physics.collisionDamping, fitted.collisionDamping,
+        startError, calibrator.getFitError(), calibrator.getEvaluationCount());
+
+    if (!fitted.save(paramsPath)) {
+        std::cerr << "Failed to write " << paramsPath << std::endl;
+        return -1;
+    }
+    std::cout << "Table parameters written to " << paramsPath << "; rebuild the break database to match" << std::endl;
+    return 0;
+}
+
+// Ball-in-hand heatmap: red where no shot is open, green where an easy one is, best spot in white
+void drawPlacementHeatmap(unsigned int shader, unsigned int circleVAO, const BallInHand& placement) {
+    // Every point of the finest level would be a draw call each; stride 2 is dense enough to read
+    int stride = std::max(placement.getStride(), 2);
+    float dotRadius = (placement.columnX(1) - placement.columnX(0)) * stride * 0.35f;
+
+    for (int row = 0; row < placement.getRows(); row += stride) {
+        for (int column = 0; column < placement.getColumns(); column += stride) {
+            float score = placement.getScore(column, row);
+            if (score < 0.0f) continue;
+            Ball::drawCircle(shader, circleVAO, NUM_CIRCLE_SEGMENTS,
+                placement.columnX(column), placement.rowY(row), dotRadius, 1.0f - score, score, 0.2f);
+        }
+    }
+
+    float bestX, bestY, bestScore;
+    if (placement.getBest(bestX, bestY, bestScore)) {
+        Ball::drawCircle(shader, circleVAO, NUM_CIRCLE_SEGMENTS, bestX, bestY, dotRadius * 2.0f, 1.0f, 1.0f, 1.0f);
+    }
+}
+
+bool checkGameOver(const BallSystem& balls) {
+    for (size_t i = 0; i < balls.size(); ++i) {
+        if (!balls.isWhite[i] && balls.active[i]) return false;
     }
     return true;
 }
 
-int main() {
+int main(int argc, char** argv) {
+    // "--build-breaks [path]" precomputes the break database instead of starting the game
+    if (argc >= 2 && std::string(argv[1]) == "--build-breaks") {
+        return buildBreakDatabase(argc >= 3 ? argv[2] : BREAK_DATABASE_PATH);
+    }
+    // "--calibrate trajectories [params]" fits the table parameters to recorded shots
+    if (argc >= 3 && std::string(argv[1]) == "--calibrate") {
+        return calibrateTable(argv[2], argc >= 4 ? argv[3] : TABLE_PARAMS_PATH);
+    }
+    // "--bench-physics" prints the state hash and us/step; the hash must match between builds
+    if (argc >= 2 && std::string(argv[1]) == "--bench-physics") {
+        return Benchmark::physics();
+    }
+    // "--bench-snapshot" prints the capture/restore cost in ns
+    if (argc >= 2 && std::string(argv[1]) == "--bench-snapshot") {
+        return Benchmark::snapshot();
+    }
+
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW" << std::endl;
         return -1;
@@ -333,7 +465,7 @@ int main() {
     glBufferData(GL_ARRAY_BUFFER, circleVertices.size() * sizeof(float), circleVertices.data(), GL_STATIC_DRAW);
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
-    Table table(-1.5f, 1.5f, 0.8f, -0.8f);
+    Table table = createTable();
     std::vector<float> tableVertices;
     Table::generateTableVertices(tableVertices, table.left, table.right, table.top, table.bottom);
     unsigned int tableVAO, tableVBO;
@@ -358,38 +490,89 @@ int main() {
     glBufferData(GL_ARRAY_BUFFER, wallVertices.size() * sizeof(float), wallVertices.data(), GL_STATIC_DRAW);
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
+    // Cushion outlines drawn over the rails and pockets, so the jaws are visible
+    std::vector<float> cushionVertices;
+    std::vector<int> cushionCounts;
+    for (const Cushion& c : table.cushions) {
+        for (const CushionPoint& point : c.points) cushionVertices.insert(cushionVertices.end(), { point.x, point.y });
+        cushionCounts.push_back((int)c.points.size());
+    }
+    unsigned int cushionVAO, cushionVBO;
+    glGenVertexArrays(1, &cushionVAO);
+    glGenBuffers(1, &cushionVBO);
+    glBindVertexArray(cushionVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, cushionVBO);
+    glBufferData(GL_ARRAY_BUFFER, cushionVertices.size() * sizeof(float), cushionVertices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
     unsigned int lineVAO;
     glGenVertexArrays(1, &lineVAO);
-    std::vector<Ball> balls;
+    BallSystem balls;
     setupBalls(balls);
+    BallRef whiteBall = balls[whiteBallIndex];
+    BreakDatabase breakDatabase;
+    breakDatabase.open(BREAK_DATABASE_PATH, balls, table);
+    JobSystem jobs;
+    BallInHand placement(jobs);
+    SimulationClock physicsClock(PHYSICS_STEP_RATE);
+    std::unique_ptr<Broadphase> broadphase = createBroadphase(BroadphaseType::Grid);
+    Narrowphase narrowphase;
     glClearColor(0.15f, 0.15f, 0.2f, 1.0f);
     float lastTime = glfwGetTime();
     bool gameOver = false;
     while (!glfwWindowShouldClose(window)) {
 
-        const double targetFrameTime = 1.0 / 75.0;
+        const double targetFrameTime = 1.0 / RENDER_FRAME_RATE;
         double frameStart = glfwGetTime();
 
         float currentTime = glfwGetTime();
         float dt = currentTime - lastTime;
         lastTime = currentTime;
-        if (dt > 0.1f) dt = 0.1f;
         glfwGetWindowSize(window, &currentScreenWidth, &currentScreenHeight);
         aspectRatio = (float)currentScreenWidth / (float)currentScreenHeight;
         float textProj[16] = { 2.0f / currentScreenWidth, 0.0f, 0.0f, 0.0f, 0.0f, 2.0f / currentScreenHeight, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, -1.0f, -1.0f, 0.0f, 1.0f };
         glUseProgram(textShader);
         glUniformMatrix4fv(glGetUniformLocation(textShader, "projection"), 1, GL_FALSE, textProj);
         glClear(GL_COLOR_BUFFER_BIT);
-        Physics::updatePhysics(balls, table, dt);
+        if (skipShotRequested) {
+            skipShotRequested = false;
+            Physics::simulateToRest(balls, table);
+            balls.storePreviousPositions();
+        }
+        int physicsSteps = physicsClock.advance(dt);
+        for (int step = 0; step < physicsSteps; ++step) {
+            balls.storePreviousPositions();
+            // Fast balls split the step into substeps; a slow table costs one
+            physicsClock.addSubsteps(Physics::updatePhysicsAdaptive(balls, table, physicsClock.getStepDt(), *broadphase, narrowphase));
+        }
+        float renderAlpha = physicsClock.getAlpha();
         if (!gameOver) {
             gameOver = checkGameOver(balls);
         }
-        if (whiteBall && !whiteBall->active && whiteBall->isWhite) {
-            whiteBall->x = whiteBallStartX;
-            whiteBall->y = whiteBallStartY;
-            whiteBall->vx = 0;
-            whiteBall->vy = 0;
-            whiteBall->active = true;
+        // A pocketed cue comes back as ball in hand once everything has stopped
+        if (!whiteBall.active && whiteBall.isWhite && !ballInHand && balls.awakeBalls().empty()) {
+            ballInHand = true;
+            placeCueRequested = false;
+            placement.start(balls, table, whiteBallIndex);
+        }
+        if (ballInHand) {
+            // One level per frame: the coarse map shows at once and sharpens over a few frames
+            placement.refine();
+            if (placeCueRequested) {
+                placeCueRequested = false;
+                float worldX, worldY;
+                screenToWorld(mouseX, mouseY, worldX, worldY);
+                if (placement.isLegal(worldX, worldY)) {
+                    whiteBall.x = worldX;
+                    whiteBall.y = worldY;
+                    whiteBall.vx = 0;
+                    whiteBall.vy = 0;
+                    balls.setActive(whiteBallIndex, true);
+                    balls.wake(whiteBallIndex);
+                    balls.snapPrevious(whiteBallIndex);
+                    ballInHand = false;
+                }
+            }
         }
         glUseProgram(shader);
         glUniform1f(glGetUniformLocation(shader, "uRadius"), 1.0f);
@@ -405,8 +588,29 @@ int main() {
         glDrawArrays(GL_TRIANGLE_FAN, 8, 4);
         glDrawArrays(GL_TRIANGLE_FAN, 12, 4);
         table.draw(shader, tableVAO, circleVAO, NUM_CIRCLE_SEGMENTS);
-        for (auto& ball : balls) {
-            ball.draw(shader, circleVAO, NUM_CIRCLE_SEGMENTS);
+        glUniform2f(glGetUniformLocation(shader, "uPos"), 0.0f, 0.0f);
+        glUniform1f(glGetUniformLocation(shader, "uRadius"), 1.0f);
+        glUniform3f(glGetUniformLocation(shader, "uColor"), 0.6f, 0.35f, 0.2f);
+        glBindVertexArray(cushionVAO);
+        for (size_t c = 0, first = 0; c < cushionCounts.size(); first += cushionCounts[c], ++c) {
+            glDrawArrays(GL_LINE_LOOP, (GLint)first, cushionCounts[c]);
+        }
+        if (ballInHand) {
+            drawPlacementHeatmap(shader, circleVAO, placement);
+        }
+        for (size_t i = 0; i < balls.size(); ++i) {
+            if (!balls.active[i]) continue;
+            Ball::drawCircle(shader, circleVAO, NUM_CIRCLE_SEGMENTS,
+                balls.renderX(i, renderAlpha), balls.renderY(i, renderAlpha), toFloat(balls.radius[i]),
+                balls.r[i], balls.g[i], balls.b[i]);
+        }
+        if (ballInHand) {
+            // Cue ball follows the mouse, greyed out where it may not be placed
+            float worldX, worldY;
+            screenToWorld(mouseX, mouseY, worldX, worldY);
+            float shade = placement.isLegal(worldX, worldY) ? 1.0f : 0.4f;
+            Ball::drawCircle(shader, circleVAO, NUM_CIRCLE_SEGMENTS, worldX, worldY,
+                toFloat(balls.radius[whiteBallIndex]), 1.0f, shade, shade);
         }
 
         double frameEnd = glfwGetTime();
@@ -419,21 +623,42 @@ int main() {
         float textX = 60.0f;
         float textY = currentScreenHeight - 60.0f;
         renderText("Luka Marić RA154/2022", textX, textY, 1.0f, 1.0f, 1.0f, 1.0f);
+        if (showStepStats) {
+            char stats[64];
+            std::snprintf(stats, sizeof(stats), "Physics: %d steps, %d substeps",
+                physicsClock.getFrameSteps(), physicsClock.getFrameSubsteps());
+            renderText(stats, textX, textY - 30.0f, 0.5f, 0.8f, 0.8f, 0.8f);
+        }
         if (gameOver) {
             float centerX = currentScreenWidth / 2.0f - 150.0f;
             float centerY = currentScreenHeight / 2.0f;
             renderText("GAME OVER", centerX, centerY, 2.0f, 1.0f, 0.2f, 0.2f);
         }
-        if (whiteBall && whiteBall->active && whiteBall->isStopped() && !gameOver) {
+        if (whiteBall.active && whiteBall.isStopped() && !gameOver) {
             float worldX, worldY;
             screenToWorld(mouseX, mouseY, worldX, worldY);
-            drawAimLine(lineShader, lineVAO, *whiteBall, worldX, worldY);
+            drawAimLine(lineShader, lineVAO, whiteBall, worldX, worldY);
             if (isCharging) {
                 float chargeTime = static_cast<float>(glfwGetTime() - chargeStartTime);
                 chargeTime = clamp(chargeTime, 0.0f, CHARGE_DURATION);
                 float powerPercent = chargeTime / CHARGE_DURATION;
                 drawPowerBar(shader, powerPercent);
             }
+            if (!breakShotTaken && breakDatabase.isOpen()) {
+                // Full power until the player starts charging
+                float powerPercent = 1.0f;
+                if (isCharging) powerPercent = clamp(static_cast<float>(glfwGetTime() - chargeStartTime), 0.0f, CHARGE_DURATION) / CHARGE_DURATION;
+                float power = MIN_POWER + (MAX_POWER - MIN_POWER) * powerPercent;
+                float angle = std::atan2(worldY - toFloat(whiteBall.y), worldX - toFloat(whiteBall.x));
+
+                BreakEstimate estimate;
+                if (breakDatabase.estimate(toFloat(whiteBall.x), toFloat(whiteBall.y), angle, power, estimate)) {
+                    char preview[64];
+                    std::snprintf(preview, sizeof(preview), "Break: %.1f balls, scratch %d%%",
+                        estimate.expectedPocketed, (int)(estimate.scratchProbability * 100.0f + 0.5f));
+                    renderText(preview, textX, textY - 60.0f, 0.6f, 1.0f, 1.0f, 1.0f);
+                }
+            }
         }
         glfwSwapBuffers(window);
         glfwPollEvents();
@@ -445,6 +670,8 @@ int main() {
     glDeleteVertexArrays(1, &wallVAO);
     glDeleteBuffers(1, &wallVBO);
     glDeleteVertexArrays(1, &lineVAO);
+    glDeleteVertexArrays(1, &cushionVAO);
+    glDeleteBuffers(1, &cushionVBO);
     glDeleteVertexArrays(1, &textVAO);
     glDeleteBuffers(1, &textVBO);
     glDeleteProgram(shader);
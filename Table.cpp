@@ -1,5 +1,10 @@
 #include "Table.h"
+#include "BoundaryField.h"
+#include "PocketGrid.h"
+#include "SegmentBVH.h"
+#include "Physics.h"
 #include "Header/Util.h"
+#include <algorithm>
 #include <cmath>
 
 Table::Table() : left(-0.8f), right(0.8f), top(0.5f), bottom(-0.5f), cushionThickness(0.03f) {
@@ -29,6 +34,164 @@ void Table::setupPockets() {
     float midX = (left + right) / 2.0f;
     pockets.push_back(Pocket(midX, top, pocketRadius * 0.9f));
     pockets.push_back(Pocket(midX, bottom, pocketRadius * 0.9f));
+
+    buildCushions();
+    rebuildGeometry();
+}
+
+void Table::setCushions(const std::vector<Cushion>& cushions) {
+    this->cushions = cushions;
+    rebuildGeometry();
+}
+
+void Table::rebuildGeometry() {
+    // The field is baked from the tree, so the tree comes first
+    cushionTree = std::make_shared<SegmentBVH>(cushions);
+    boundary = std::make_shared<BoundaryField>(*this);
+    pocketGrid = std::make_shared<PocketGrid>(*this);
+}
+
+namespace {
+    const double PI = 3.14159265358979323846;
+
+    // Largest angle one straight piece of a pocket's back wall covers
+    const double ARC_STEP = PI / 12.0;
+
+    // Part of the rail outline that lies inside one pocket circle, as perimeter positions
+    struct Mouth {
+        double enter, exit;
+        int pocket;
+    };
+}
+
+// Roughly 38 and 76 degrees, like the jaws of a real table: corner throats narrow quickly,
+// side pockets are nearly straight
+const float Table::CORNER_JAW_ANGLE = 0.66f;
+const float Table::SIDE_JAW_ANGLE = 1.33f;
+
+void Table::buildCushions() {
+    cushions.clear();
+
+    // The inner rectangle, counterclockwise, walked as one perimeter
+    const double inner[4][2] = {
+        { left + cushionThickness, bottom + cushionThickness }, { right - cushionThickness, bottom + cushionThickness },
+        { right - cushionThickness, top - cushionThickness }, { left + cushionThickness, top - cushionThickness }
+    };
+    double start[5];
+    start[0] = 0.0;
+    for (int side = 0; side < 4; ++side) {
+        const double* a = inner[side];
+        const double* b = inner[(side + 1) % 4];
+        start[side + 1] = start[side] + std::fabs(b[0] - a[0]) + std::fabs(b[1] - a[1]);
+    }
+    const double perimeter = start[4];
+
+    auto sideAt = [&](double s) {
+        s = std::fmod(s, perimeter);
+        int side = 0;
+        while (side < 3 && s >= start[side + 1]) side++;
+        return side;
+    };
+    auto pointAt = [&](double s, double& x, double& y, double& ux, double& uy) {
+        s = std::fmod(s, perimeter);
+        int side = sideAt(s);
+        const double* a = inner[side];
+        const double* b = inner[(side + 1) % 4];
+        double length = start[side + 1] - start[side];
+        ux = (b[0] - a[0]) / length;
+        uy = (b[1] - a[1]) / length;
+        x = a[0] + ux * (s - start[side]);
+        y = a[1] + uy * (s - start[side]);
+    };
+
+    // Each pocket circle that cuts the outline twice opens a mouth in it
+    std::vector<Mouth> mouths;
+    for (size_t k = 0; k < pockets.size(); ++k) {
+        const Pocket& pocket = pockets[k];
+        std::vector<double> crossings;
+        for (int side = 0; side < 4; ++side) {
+            const double* a = inner[side];
+            const double* b = inner[(side + 1) % 4];
+            double length = start[side + 1] - start[side];
+            double ux = (b[0] - a[0]) / length, uy = (b[1] - a[1]) / length;
+            double along = (pocket.x - a[0]) * ux + (pocket.y - a[1]) * uy;
+            double across = (pocket.x - a[0]) * uy - (pocket.y - a[1]) * ux;
+            double half2 = (double)pocket.radius * pocket.radius - across * across;
+            if (half2 <= 0.0) continue;
+            double half = std::sqrt(half2);
+            if (along - half >= 0.0 && along - half < length) crossings.push_back(start[side] + along - half);
+            if (along + half >= 0.0 && along + half < length) crossings.push_back(start[side] + along + half);
+        }
+        if (crossings.size() != 2) continue;
+        std::sort(crossings.begin(), crossings.end());
+
+        double x, y, ux, uy;
+        pointAt(0.5 * (crossings[0] + crossings[1]), x, y, ux, uy);
+        bool inside = std::hypot(x - pocket.x, y - pocket.y) < pocket.radius;
+        mouths.push_back(inside ? Mouth{ crossings[0], crossings[1], (int)k }
+                                : Mouth{ crossings[1], crossings[0] + perimeter, (int)k });
+    }
+    std::sort(mouths.begin(), mouths.end(), [](const Mouth& a, const Mouth& b) { return a.enter < b.enter; });
+
+    Cushion cushion;
+    auto add = [&cushion](double x, double y) {
+        CushionPoint point = { (float)x, (float)y };
+        if (!cushion.points.empty() && cushion.points.back().x == point.x && cushion.points.back().y == point.y) return;
+        cushion.points.push_back(point);
+    };
+
+    if (mouths.empty()) {
+        for (int corner = 0; corner < 4; ++corner) add(inner[corner][0], inner[corner][1]);
+        cushions.push_back(cushion);
+        return;
+    }
+
+    for (size_t m = 0; m < mouths.size(); ++m) {
+        const Mouth& previous = mouths[(m + mouths.size() - 1) % mouths.size()];
+        const Mouth& mouth = mouths[m];
+        const Pocket& pocket = pockets[mouth.pocket];
+
+        // Rail from the previous mouth, through the rectangle corners no pocket covers
+        double from = std::fmod(previous.exit, perimeter);
+        double to = mouth.enter;
+        while (to <= from) to += perimeter;
+        for (int lap = 0; lap < 2; ++lap) {
+            for (int corner = 0; corner < 4; ++corner) {
+                double s = start[corner] + lap * perimeter;
+                if (s > from && s < to) add(inner[corner][0], inner[corner][1]);
+            }
+        }
+
+        // Jaws leave the rail ends at the jaw angle and run through the cushion depth;
+        // the back wall follows the pocket circle (or the jaw ends, if they lie outside it)
+        double x1, y1, ux1, uy1, x2, y2, ux2, uy2;
+        pointAt(mouth.enter, x1, y1, ux1, uy1);
+        pointAt(mouth.exit, x2, y2, ux2, uy2);
+        double angle = sideAt(mouth.enter) != sideAt(mouth.exit) ? CORNER_JAW_ANGLE : SIDE_JAW_ANGLE;
+        double jaw = cushionThickness / std::sin(angle);
+        double c = std::cos(angle), s = std::sin(angle);
+        double jx1 = x1 + jaw * (c * ux1 + s * uy1);
+        double jy1 = y1 + jaw * (c * uy1 - s * ux1);
+        double jx2 = x2 + jaw * (-c * ux2 + s * uy2);
+        double jy2 = y2 + jaw * (-c * uy2 - s * ux2);
+
+        double back = std::max((double)pocket.radius,
+            std::max(std::hypot(jx1 - pocket.x, jy1 - pocket.y), std::hypot(jx2 - pocket.x, jy2 - pocket.y)));
+        double from1 = std::atan2(jy1 - pocket.y, jx1 - pocket.x);
+        double to2 = std::atan2(jy2 - pocket.y, jx2 - pocket.x);
+        while (to2 <= from1) to2 += 2.0 * PI;
+        int pieces = std::max(1, (int)std::ceil((to2 - from1) / ARC_STEP));
+
+        add(x1, y1);
+        add(jx1, jy1);
+        for (int k = 0; k <= pieces; ++k) {
+            double a = from1 + (to2 - from1) * k / pieces;
+            add(pocket.x + back * std::cos(a), pocket.y + back * std::sin(a));
+        }
+        add(jx2, jy2);
+        add(x2, y2);
+    }
+    cushions.push_back(cushion);
 }
 
 void Table::draw(unsigned int shaderProgram, unsigned int tableVAO, unsigned int pocketVAO, int numPocketSegments) {
@@ -50,11 +213,12 @@ void Table::draw(unsigned int shaderProgram, unsigned int tableVAO, unsigned int
 }
 
 bool Table::isInPocket(float x, float y, float ballRadius) const {
-    for (const auto& pocket : pockets) {
-        float dist = distance(x, y, pocket.x, pocket.y);
-        if (dist < pocket.radius * 0.7f) {
-            return true;
-        }
+    int k = pocketGrid->pocketAt(x, y, ballRadius);
+    if (k == PocketGrid::NONE) return false;
+
+    for (size_t p = 0; p < pockets.size(); ++p) {
+        if (k != PocketGrid::SEVERAL && (int)p != k) continue;
+        if (distance(x, y, pockets[p].x, pockets[p].y) < pockets[p].radius * Physics::POCKET_CAPTURE) return true;
     }
     return false;
 }
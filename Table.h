@@ -1,6 +1,8 @@
 #ifndef TABLE_H
 #define TABLE_H
 
+#include "PhysicsParams.h"
+#include <memory>
 #include <vector>
 #include <GL/glew.h>
 
@@ -11,20 +13,65 @@ struct Pocket {
     Pocket(float x, float y, float radius) : x(x), y(y), radius(radius) {}
 };
 
+struct CushionPoint {
+    float x, y;
+};
+
+// Guma kao zatvorena izlomljena linija (poslednja tacka se spaja sa prvom).
+// Tkanina je levo od smera obilaska: spoljna ivica stola ide suprotno od
+// kazaljke na satu, a prepreka na sredini stola u smeru kazaljke.
+struct Cushion {
+    std::vector<CushionPoint> points;
+};
+
+class BoundaryField;
+class PocketGrid;
+class SegmentBVH;
+
 class Table {
 public:
     float left, right, top, bottom;
     float cushionThickness;
     std::vector<Pocket> pockets;
+    std::vector<Cushion> cushions;
+    PhysicsParams physics;
+
+    // Ugao cela gume kod usta dzepa prema pravcu gume (radijani): manji ugao vise suzava grlo
+    static const float CORNER_JAW_ANGLE;
+    static const float SIDE_JAW_ANGLE;
 
     Table();
     Table(float left, float right, float top, float bottom);
 
+    // Gradi geometriju standardnog stola: sest dzepova i jednu gumu oko unutrasnjeg
+    // pravougaonika (bez cushionThickness) sa kosim celima na ustima i lukom iza
+    // svakog dzepa, pa pravi izvedene strukture (posle promene dimenzija stola)
     void setupPockets();
+
+    // Sto sa proizvoljnim gumama (dzepovi ostaju); ponovo pravi izvedene strukture
+    void setCushions(const std::vector<Cushion>& cushions);
+
+    // Ivica igracke povrsine sa izrezanim ustima dzepova; kopije stola dele isto polje
+    const BoundaryField& getBoundary() const { return *boundary; }
+
+    // Koji dzep moze da deluje na kuglu u datom delu stola
+    const PocketGrid& getPocketGrid() const { return *pocketGrid; }
+
+    // BVH nad ivicama guma, za tacne upite (CCD, dogadjaji, pecenje BoundaryField-a)
+    const SegmentBVH& getCushionTree() const { return *cushionTree; }
+
     void draw(unsigned int shaderProgram, unsigned int tableVAO, unsigned int pocketVAO, int numPocketSegments);
     bool isInPocket(float x, float y, float ballRadius) const;
 
     static void generateTableVertices(std::vector<float>& vertices, float left, float right, float top, float bottom);
+
+private:
+    void buildCushions();
+    void rebuildGeometry();
+
+    std::shared_ptr<const SegmentBVH> cushionTree;
+    std::shared_ptr<const BoundaryField> boundary;
+    std::shared_ptr<const PocketGrid> pocketGrid;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include "TableState.h"
+#include <cmath>
+#include <stdexcept>
+
+static_assert(sizeof(PackedBall) == 8, "PackedBall must stay 8 bytes");
+
+TableStateBuffer::TableStateBuffer(const Table& table, const BallSystem& layout, float maxSpeed)
+    : table(&table), layout(layout), ballCount(layout.size()), tableCount(0) {
+    if (ballCount > MAX_BALLS) throw std::invalid_argument("TableStateBuffer: too many balls for the active mask");
+
+    // The whole playing area maps onto [0, 65535]; balls never leave it while active
+    originX = table.left;
+    originY = table.bottom;
+    positionScaleX = 65535.0f / (table.right - table.left);
+    positionScaleY = 65535.0f / (table.top - table.bottom);
+    velocityScale = 32767.0f / maxSpeed;
+
+    this->layout.wakeAll();
+}
+
+void TableStateBuffer::resize(size_t tableCount) {
+    this->tableCount = tableCount;
+    packed.resize(tableCount * ballCount);
+    masks.resize(tableCount);
+}
+
+static uint16_t quantizePosition(float value, float origin, float scale) {
+    float steps = std::floor((value - origin) * scale + 0.5f);
+    steps = steps < 0.0f ? 0.0f : (steps > 65535.0f ? 65535.0f : steps);
+    return (uint16_t)steps;
+}
+
+static int16_t quantizeVelocity(float value, float scale) {
+    float steps = std::floor(value * scale + 0.5f);
+    steps = steps < -32767.0f ? -32767.0f : (steps > 32767.0f ? 32767.0f : steps);
+    return (int16_t)steps;
+}
+
+void TableStateBuffer::pack(size_t k, const BallSystem& balls) {
+    PackedBall* out = &packed[k * ballCount];
+    uint32_t mask = 0;
+
+    for (size_t i = 0; i < ballCount; ++i) {
+        out[i].x = quantizePosition(toFloat(balls.x[i]), originX, positionScaleX);
+        out[i].y = quantizePosition(toFloat(balls.y[i]), originY, positionScaleY);
+        out[i].vx = quantizeVelocity(toFloat(balls.vx[i]), velocityScale);
+        out[i].vy = quantizeVelocity(toFloat(balls.vy[i]), velocityScale);
+        if (balls.active[i]) mask |= 1u << i;
+    }
+    masks[k] = mask;
+}
+
+void TableStateBuffer::unpack(size_t k, BallSystem& balls) const {
+    if (balls.size() != ballCount) balls = layout;
+
+    const PackedBall* in = &packed[k * ballCount];
+    const uint32_t mask = masks[k];
+    const float stepX = 1.0f / positionScaleX;
+    const float stepY = 1.0f / positionScaleY;
+    const float stepV = 1.0f / velocityScale;
+
+    for (size_t i = 0; i < ballCount; ++i) {
+        balls.x[i] = Real(originX + in[i].x * stepX);
+        balls.y[i] = Real(originY + in[i].y * stepY);
+        balls.vx[i] = Real(in[i].vx * stepV);
+        balls.vy[i] = Real(in[i].vy * stepV);
+        balls.active[i] = (mask >> i & 1u) != 0;
+    }
+
+    // wakeAll also marks the awake list dirty after the active flags changed
+    balls.wakeAll();
+    balls.storePreviousPositions();
+}
+
+size_t TableStateBuffer::bytes() const {
+    return packed.capacity() * sizeof(PackedBall) + masks.capacity() * sizeof(uint32_t);
+}
@@ -0,0 +1,64 @@
+#ifndef TABLE_STATE_H
+#define TABLE_STATE_H
+
+#include "BallSystem.h"
+#include "Table.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Jedna kugla u 8 bajtova: pozicija u 16 bita relativno na ivice stola,
+// brzina u 16 bita sa znakom u opsegu [-maxSpeed, maxSpeed]
+struct PackedBall {
+    uint16_t x, y;
+    int16_t vx, vy;
+};
+
+// Kompaktno skladiste za mnogo stolova sa istim rasporedom kugli (npr. milion
+// varijacija udarca koje cekaju na simulaciju). Po stolu se cuvaju samo
+// pozicije, brzine i maska aktivnih kugli; radijus, boje i isWhite su iz
+// zajednickog rasporeda, a sto (ivice i dzepovi) se deli preko reference.
+//
+// Korak kvantizacije na podrazumevanom stolu je ~2.4e-5 za poziciju i
+// ~2.4e-4 jedinica/s za brzinu. Spavanje se ne cuva: raspakovane kugle su
+// budne, a one koje miruju zaspu posle SLEEP_STEPS koraka.
+class TableStateBuffer {
+public:
+    // Najvise kugli po stolu (jedan bit maske po kugli)
+    static const size_t MAX_BALLS = 32;
+
+    // layout daje broj kugli i nepromenljive osobine; sto mora da nadzivi bafer
+    TableStateBuffer(const Table& table, const BallSystem& layout, float maxSpeed = 8.0f);
+
+    void resize(size_t tableCount);
+    size_t size() const { return tableCount; }
+    size_t getBallCount() const { return ballCount; }
+    const Table& getTable() const { return *table; }
+
+    // Upisuje stanje stola k (balls mora imati isti broj kugli kao raspored)
+    void pack(size_t k, const BallSystem& balls);
+
+    // Vraca sto k u balls. Ako balls nema raspored, prvo se kopira raspored.
+    void unpack(size_t k, BallSystem& balls) const;
+
+    uint32_t activeMask(size_t k) const { return masks[k]; }
+    const PackedBall* tableBalls(size_t k) const { return &packed[k * ballCount]; }
+
+    // Zauzeta memorija za stanja stolova (bez zajednickog rasporeda)
+    size_t bytes() const;
+
+private:
+    const Table* table;
+    BallSystem layout;
+    size_t ballCount;
+    size_t tableCount;
+
+    float originX, originY;
+    float positionScaleX, positionScaleY;  // jedinica -> korak
+    float velocityScale;
+
+    std::vector<PackedBall> packed;        // ballCount kugli po stolu, stolovi jedan za drugim
+    std::vector<uint32_t> masks;
+};
+
+#endif